@@ -19,6 +19,7 @@
 #include <QApplication>
 #include <QDir>
 #include <QIcon>
+#include <QStandardPaths>
 
 #include <KAboutData>
 #include <KDBusService>
@@ -43,7 +44,9 @@ int main(int argc, char** argv) {
   KAboutData::setApplicationData(about);
   QApplication::setWindowIcon(QIcon::fromTheme("user-desktop"));
 
-  ksmoothdock::MultiDockModel model(QDir::homePath() + "/.ksmoothdock");
+  ksmoothdock::MultiDockModel model(
+      QDir::homePath() + "/.ksmoothdock",
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
   ksmoothdock::MultiDockView view(&model);
   view.show();
   return app.exec();
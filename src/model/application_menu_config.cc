@@ -22,10 +22,18 @@
 #include <iostream>
 
 #include <QApplication>
+#include <QDataStream>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSaveFile>
 #include <QStringBuilder>
 #include <QUrl>
+#include <QVector>
+#include <QtConcurrent>
 
+#include <KConfig>
 #include <KDesktopFile>
 #include <KLocalizedString>
 
@@ -33,48 +41,130 @@
 
 namespace ksmoothdock {
 
+constexpr int ApplicationMenuConfig::kReloadQuietPeriodMs;
+constexpr int ApplicationMenuConfig::kReloadMaxDelayMs;
+constexpr quint32 ApplicationMenuConfig::kIndexMagic;
+constexpr quint32 ApplicationMenuConfig::kIndexVersion;
+
+namespace {
+
+// An application entry parsed from a .desktop file.
+struct ParsedEntry {
+  // The categories of the entry. Empty if the entry should not be shown.
+  QStringList categories;
+
+  QString name;
+  QString genericName;
+  QString icon;
+  QString command;
+  QString taskCommand;
+  QStringList keywords;
+  QString startupWMClass;
+  QString flatpakAppId;
+};
+
+// Parses an application entry from the .desktop file.
+// This is called concurrently from the thread pool.
+ParsedEntry parseEntry(const QString& file) {
+  ParsedEntry entry;
+  KDesktopFile desktopFile(file);
+  if (desktopFile.noDisplay()) {
+    return entry;
+  }
+
+  // Reads the group map once, as it is copied on every call.
+  const auto entryMap = desktopFile.entryMap("Desktop Entry");
+  if (entryMap.value("Hidden").trimmed().toLower() == "true") {
+    return entry;
+  }
+
+  entry.categories =
+      entryMap.value("Categories").split(';', Qt::SkipEmptyParts);
+  if (entry.categories.isEmpty()) {
+    return entry;
+  }
+
+  entry.name = desktopFile.readName();
+  entry.genericName = desktopFile.readGenericName();
+  entry.icon = desktopFile.readIcon();
+  entry.command = filterFieldCodes(entryMap.value("Exec"));
+  entry.taskCommand = getTaskCommand(entry.command);
+  entry.keywords = desktopFile.desktopGroup().readXdgListEntry("Keywords");
+  entry.startupWMClass = entryMap.value("StartupWMClass");
+  entry.flatpakAppId = entryMap.value("X-Flatpak");
+  return entry;
+}
+
+ApplicationEntry toApplicationEntry(const ParsedEntry& parsedEntry,
+                                    const QString& file) {
+  ApplicationEntry entry(parsedEntry.name, parsedEntry.genericName,
+                         parsedEntry.icon, parsedEntry.command,
+                         parsedEntry.taskCommand, file);
+  entry.keywords = parsedEntry.keywords;
+  entry.startupWMClass = parsedEntry.startupWMClass;
+  entry.flatpakAppId = parsedEntry.flatpakAppId;
+  return entry;
+}
+
+// Parses the .desktop files in parallel on the global thread pool.
+QVector<ParsedEntry> parseEntries(const QStringList& files) {
+  return QtConcurrent::blockingMapped<QVector<ParsedEntry>>(files, parseEntry);
+}
+
+}  // namespace
+
+const std::vector<ApplicationEntry>
+ApplicationMenuConfig::kSessionSystemEntries = {
+  {"Lock Screen",
+    "",
+    "system-lock-screen",
+    "qdbus org.kde.screensaver /ScreenSaver Lock",
+    ""},
+  {"Log Out",
+    "",
+    "system-log-out",
+    "qdbus org.kde.ksmserver /KSMServer logout -1 0 3",
+    ""},
+  {"Switch User",
+    "",
+    "system-switch-user",
+    "qdbus org.kde.ksmserver /KSMServer openSwitchUserDialog",
+    ""},
+  {"Suspend",
+    "",
+    "system-suspend",
+    "qdbus org.kde.Solid.PowerManagement /org/freedesktop/PowerManagement "
+    "Suspend",
+    ""},
+  {"Hibernate",
+    "",
+    "system-suspend-hibernate",
+    "qdbus org.kde.Solid.PowerManagement /org/freedesktop/PowerManagement "
+    "Hibernate",
+    ""},
+  {"Reboot",
+    "",
+    "system-reboot",
+    "qdbus org.kde.ksmserver /KSMServer logout -1 1 3",
+    ""},
+  {"Shut Down",
+    "",
+    "system-shutdown",
+    "qdbus org.kde.ksmserver /KSMServer logout -1 2 3",
+    ""}
+};
 const std::vector<Category> ApplicationMenuConfig::kSessionSystemCategories = {
   {"Session", "Session", "system-switch-user", {
-    {"Lock Screen",
-      "",
-      "system-lock-screen",
-      "qdbus org.kde.screensaver /ScreenSaver Lock",
-      ""},
-    {"Log Out",
-      "",
-      "system-log-out",
-      "qdbus org.kde.ksmserver /KSMServer logout -1 0 3",
-      ""},
-    {"Switch User",
-      "",
-      "system-switch-user",
-      "qdbus org.kde.ksmserver /KSMServer openSwitchUserDialog",
-      ""}
+    &kSessionSystemEntries[0],  // Lock Screen
+    &kSessionSystemEntries[1],  // Log Out
+    &kSessionSystemEntries[2]   // Switch User
     }
   },
   {"Power", "Power", "system-shutdown", {
-    {"Suspend",
-      "",
-      "system-suspend",
-      "qdbus org.kde.Solid.PowerManagement /org/freedesktop/PowerManagement "
-      "Suspend",
-      ""},
-    {"Hibernate",
-      "",
-      "system-suspend-hibernate",
-      "qdbus org.kde.Solid.PowerManagement /org/freedesktop/PowerManagement "
-      "Hibernate",
-      ""},
-    {"Reboot",
-      "",
-      "system-reboot",
-      "qdbus org.kde.ksmserver /KSMServer logout -1 1 3",
-      ""},
-    {"Shut Down",
-      "",
-      "system-shutdown",
-      "qdbus org.kde.ksmserver /KSMServer logout -1 2 3",
-      ""}
+    &kSessionSystemEntries[3],  // Suspend
+    &kSessionSystemEntries[4],  // Hibernate
+    &kSessionSystemEntries[5],  // Reboot
+    &kSessionSystemEntries[6]   // Shut Down
     }
   }
 };
@@ -86,13 +176,19 @@ bool operator<(const ApplicationEntry &e1, const ApplicationEntry &e2) {
   return e1.name < e2.name;
 }
 
-ApplicationMenuConfig::ApplicationMenuConfig(const QStringList& entryDirs)
+ApplicationMenuConfig::ApplicationMenuConfig(const QStringList& entryDirs,
+                                             const QString& indexPath)
     : entryDirs_(entryDirs),
+      indexPath_(indexPath),
+      loadGeneration_(0),
       fileWatcher_(entryDirs) {
   initCategories();
   loadEntries();
+  reloadTimer_.setSingleShot(true);
+  connect(&reloadTimer_, SIGNAL(timeout()),
+          this, SLOT(reloadChangedEntryDirs()));
   connect(&fileWatcher_, SIGNAL(directoryChanged(const QString&)),
-          this, SLOT(reload()));
+          this, SLOT(onEntryDirChanged(const QString&)));
   connect(&fileWatcher_, SIGNAL(fileChanged(const QString&)),
           this, SLOT(reload()));
 }
@@ -125,80 +221,509 @@ void ApplicationMenuConfig::initCategories() {
 }
 
 bool ApplicationMenuConfig::loadEntries() {
+  ++loadGeneration_;
+  if (loadIndex()) {
+    verifyIndex();
+    return true;
+  }
+
+  QStringList files;
   for (const QString& entryDir : entryDirs_) {
     if (!QDir::root().exists(entryDir)) {
       continue;
     }
 
     QDir dir(entryDir);
-    QStringList files = dir.entryList({"*.desktop"}, QDir::Files, QDir::Name);
-    if (files.isEmpty()) {
-      continue;
-    }
-
-    for (int i = 0; i < files.size(); ++i) {
-      const QString& file = entryDir + "/" + files.at(i);
-      loadEntry(file);
+    auto& states = desktopFiles_[entryDir];
+    for (const auto& fileInfo :
+         dir.entryInfoList({"*.desktop"}, QDir::Files, QDir::Name)) {
+      files.append(entryDir + "/" + fileInfo.fileName());
+      states[fileInfo.fileName()] = {fileInfo.lastModified(), fileInfo.size()};
     }
   }
 
+  loadEntries(files);
+  saveIndex();
   return true;
 }
 
-bool ApplicationMenuConfig::loadEntry(const QString &file) {
-  KDesktopFile desktopFile(file);
-  if (desktopFile.noDisplay()) {
+void ApplicationMenuConfig::verifyIndex() {
+  QSet<QString> entryDirs;
+  for (const auto& entryDir : entryDirs_) {
+    entryDirs.insert(entryDir);
+  }
+  const int loadGeneration = loadGeneration_;
+  auto* watcher = new QFutureWatcher<EntryDirChanges>(this);
+  connect(watcher, &QFutureWatcher<EntryDirChanges>::finished, this,
+          [this, watcher, loadGeneration] {
+            watcher->deleteLater();
+            if (loadGeneration != loadGeneration_) {
+              // The entries have been reloaded in the meantime.
+              verifyIndex();
+              return;
+            }
+            applyEntryDirChanges(watcher->result());
+          });
+  watcher->setFuture(QtConcurrent::run(
+      &ApplicationMenuConfig::findEntryDirChanges, entryDirs, desktopFiles_));
+}
+
+QString ApplicationMenuConfig::desktopFileLocale() {
+  // KDesktopFile reads the translated names in KConfig's locale.
+  return KConfig(QString(), KConfig::SimpleConfig).locale();
+}
+
+QString ApplicationMenuConfig::indexKey() const {
+  // The menu's own strings follow LANGUAGE.
+  QString key = desktopFileLocale() + ";" + qEnvironmentVariable("LANGUAGE");
+  for (const auto& entryDir : entryDirs_) {
+    const QFileInfo dirInfo(entryDir);
+    key += ";" + entryDir + ":" + (dirInfo.exists()
+        ? QString::number(dirInfo.lastModified().toMSecsSinceEpoch())
+        : QString());
+  }
+  return key;
+}
+
+bool ApplicationMenuConfig::loadIndex() {
+  if (indexPath_.isEmpty()) {
+    return false;
+  }
+
+  QFile file(indexPath_);
+  if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
     return false;
   }
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_11);
 
-  if (desktopFile.entryMap("Desktop Entry").contains("Hidden")) {
-    const QString hidden = desktopFile.entryMap("Desktop Entry")["Hidden"];
-    if (hidden.trimmed().toLower() == "true") {
-      return false;
+  quint32 magic, version;
+  QString key;
+  in >> magic >> version >> key;
+  if (in.status() != QDataStream::Ok || magic != kIndexMagic ||
+      version != kIndexVersion || key != indexKey()) {
+    return false;
+  }
+
+  QHash<QString, QHash<QString, DesktopFileState>> desktopFiles;
+  quint32 numEntryDirs;
+  in >> numEntryDirs;
+  for (quint32 i = 0; i < numEntryDirs && in.status() == QDataStream::Ok;
+       ++i) {
+    QString entryDir;
+    quint32 numFiles;
+    in >> entryDir >> numFiles;
+    auto& states = desktopFiles[entryDir];
+    for (quint32 j = 0; j < numFiles && in.status() == QDataStream::Ok; ++j) {
+      QString fileName;
+      qint64 lastModified, size;
+      in >> fileName >> lastModified >> size;
+      states[fileName] =
+          {QDateTime::fromMSecsSinceEpoch(lastModified), size};
     }
   }
 
-  const QStringList categories =
-      desktopFile.entryMap("Desktop Entry")["Categories"]
-          .split(';', Qt::SkipEmptyParts);
-  if (categories.isEmpty()) {
+  QVector<ParsedEntry> parsedEntries;
+  QStringList files;
+  quint32 numEntries;
+  in >> numEntries;
+  for (quint32 i = 0; i < numEntries && in.status() == QDataStream::Ok; ++i) {
+    ParsedEntry entry;
+    QString file;
+    in >> file >> entry.categories >> entry.name >> entry.genericName
+       >> entry.icon >> entry.command >> entry.taskCommand >> entry.keywords
+       >> entry.startupWMClass >> entry.flatpakAppId;
+    files.append(file);
+    parsedEntries.append(entry);
+  }
+  if (in.status() != QDataStream::Ok) {
     return false;
   }
 
-  for (int i = 0; i < categories.size(); ++i) {
-    const std::string category = categories[i].toStdString();
-    if (categoryMap_.count(category) > 0) {
-      const QString command = filterFieldCodes(
-          desktopFile.entryMap("Desktop Entry")["Exec"]);
-      ApplicationEntry newEntry(desktopFile.readName(),
-                                desktopFile.readGenericName(),
-                                desktopFile.readIcon(),
-                                command,
-                                file);
-      auto& entries = categories_[categoryMap_[category]].entries;
-      auto next = std::lower_bound(entries.begin(), entries.end(), newEntry);
-      entries.insert(next, newEntry);
+  desktopFiles_ = desktopFiles;
+  for (int i = 0; i < parsedEntries.size(); ++i) {
+    addEntry(toApplicationEntry(parsedEntries[i], files[i]),
+             parsedEntries[i].categories);
+  }
+  buildIndices();
+  return true;
+}
+
+void ApplicationMenuConfig::saveIndex() const {
+  if (indexPath_.isEmpty()) {
+    return;
+  }
 
-      entries_[newEntry.taskCommand.toStdString()] = &(*--next);
+  // Map from desktop files to their entries and categories.
+  QHash<QString, std::pair<const ApplicationEntry*, QStringList>> entries;
+  for (const auto& category : categories_) {
+    for (const auto* entry : category.entries) {
+      auto& value = entries[entry->desktopFile];
+      value.first = entry;
+      value.second.append(category.name);
+    }
+  }
+
+  QSaveFile file(indexPath_);
+  if (!file.open(QIODevice::WriteOnly)) {
+    std::cerr << "Failed to save application index to: "
+              << indexPath_.toStdString() << std::endl;
+    return;
+  }
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_11);
+  out << kIndexMagic << kIndexVersion << indexKey();
+
+  out << static_cast<quint32>(desktopFiles_.size());
+  for (auto it = desktopFiles_.begin(); it != desktopFiles_.end(); ++it) {
+    out << it.key() << static_cast<quint32>(it->size());
+    for (auto state = it->begin(); state != it->end(); ++state) {
+      out << state.key() << state->lastModified.toMSecsSinceEpoch()
+          << state->size;
+    }
+  }
+
+  // Entries are saved in the same order as they are loaded from the desktop
+  // files, as later entries take precedence in the task command index.
+  QStringList files;
+  for (const auto& entryDir : entryDirs_) {
+    QStringList fileNames = desktopFiles_.value(entryDir).keys();
+    fileNames.sort();
+    for (const auto& fileName : fileNames) {
+      const QString path = entryDir + "/" + fileName;
+      if (entries.contains(path)) {
+        files.append(path);
+      }
+    }
+  }
+
+  out << static_cast<quint32>(files.size());
+  for (const auto& path : files) {
+    const auto& value = entries[path];
+    const ApplicationEntry& entry = *value.first;
+    out << path << value.second << entry.name << entry.genericName
+        << entry.icon << entry.command << entry.taskCommand << entry.keywords
+        << entry.startupWMClass << entry.flatpakAppId;
+  }
+
+  file.commit();
+}
+
+void ApplicationMenuConfig::loadEntries(const QStringList& files,
+                                        QSet<QString>* changedCategories) {
+  // Parse phase, in parallel.
+  const auto parsedEntries = parseEntries(files);
+
+  // Merge phase, in order so that the result is the same as parsing
+  // the files one by one.
+  for (int i = 0; i < parsedEntries.size(); ++i) {
+    const auto& parsedEntry = parsedEntries[i];
+    if (parsedEntry.categories.isEmpty()) {
+      continue;
+    }
+
+    addEntry(toApplicationEntry(parsedEntry, files[i]),
+             parsedEntry.categories, changedCategories);
+  }
+  buildIndices();
+}
+
+void ApplicationMenuConfig::addEntry(const ApplicationEntry& entry,
+                                     const QStringList& categories,
+                                     QSet<QString>* changedCategories) {
+  std::vector<int> categoryIndices;
+  for (const auto& category : categories) {
+    const auto it = categoryMap_.find(category.toStdString());
+    if (it != categoryMap_.end() &&
+        std::find(categoryIndices.begin(), categoryIndices.end(),
+                  it->second) == categoryIndices.end()) {
+      categoryIndices.push_back(it->second);
+    }
+  }
+  if (categoryIndices.empty()) {
+    return;
+  }
+
+  int index;
+  if (freeEntryIndices_.empty()) {
+    index = static_cast<int>(entryArena_.size());
+    entryArena_.push_back(entry);
+  } else {
+    index = freeEntryIndices_.back();
+    freeEntryIndices_.pop_back();
+    entryArena_[index] = entry;
+  }
+  entryIndices_[entry.desktopFile] = index;
+
+  ApplicationEntry& storedEntry = entryArena_[index];
+  storedEntry.name = intern(storedEntry.name);
+  storedEntry.genericName = intern(storedEntry.genericName);
+  storedEntry.icon = intern(storedEntry.icon);
+  storedEntry.command = intern(storedEntry.command);
+  storedEntry.taskCommand = intern(storedEntry.taskCommand);
+  for (auto& keyword : storedEntry.keywords) {
+    keyword = intern(keyword);
+  }
+  storedEntry.startupWMClass = intern(storedEntry.startupWMClass);
+  storedEntry.flatpakAppId = intern(storedEntry.flatpakAppId);
+
+  for (const int categoryIndex : categoryIndices) {
+    auto& category = categories_[categoryIndex];
+    auto next = std::lower_bound(
+        category.entries.begin(), category.entries.end(), &storedEntry,
+        [](const ApplicationEntry* e1, const ApplicationEntry* e2) {
+          return *e1 < *e2;
+        });
+    category.entries.insert(next, &storedEntry);
+    if (changedCategories) {
+      changedCategories->insert(category.name);
     }
   }
-  return true;
+}
+
+int ApplicationMenuConfig::removeEntries(const QString& file,
+                                         QSet<QString>* changedCategories) {
+  const auto it = entryIndices_.find(file);
+  if (it == entryIndices_.end()) {
+    return -1;
+  }
+  const int index = *it;
+  entryIndices_.erase(it);
+
+  const ApplicationEntry* entry = &entryArena_[index];
+  for (auto& category : categories_) {
+    auto& entries = category.entries;
+    const auto entryIt = std::find(entries.begin(), entries.end(), entry);
+    if (entryIt != entries.end()) {
+      entries.erase(entryIt);
+      changedCategories->insert(category.name);
+    }
+  }
+
+  // See entryArena_.
+  entryArena_[index] = ApplicationEntry("", "", "", "", "", "");
+  return index;
+}
+
+QString ApplicationMenuConfig::intern(const QString& s) {
+  const auto it = strings_.constFind(s);
+  if (it != strings_.constEnd()) {
+    return *it;
+  }
+  strings_.insert(s);
+  return s;
+}
+
+void ApplicationMenuConfig::pruneStrings() {
+  QSet<QString> strings;
+  for (const auto& entry : entryArena_) {
+    if (entry.desktopFile.isEmpty()) {  // Removed.
+      continue;
+    }
+    strings.insert(entry.name);
+    strings.insert(entry.genericName);
+    strings.insert(entry.icon);
+    strings.insert(entry.command);
+    strings.insert(entry.taskCommand);
+    for (const auto& keyword : entry.keywords) {
+      strings.insert(keyword);
+    }
+    strings.insert(entry.startupWMClass);
+    strings.insert(entry.flatpakAppId);
+  }
+  strings_.swap(strings);
+}
+
+void ApplicationMenuConfig::buildIndices() {
+  searchIndex_.build(categories_);
+
+  // Entries from later entry dirs, then later desktop files, take precedence
+  // for keys of the same kind, e.g. ~/.local/share/applications overrides
+  // /usr/share/applications.
+  QHash<QString, int> entryDirIndices;
+  for (int i = 0; i < entryDirs_.size(); ++i) {
+    entryDirIndices[entryDirs_[i]] = i;
+  }
+  std::vector<std::pair<int, const ApplicationEntry*>> entries;
+  for (const auto& entry : entryArena_) {
+    if (!entry.desktopFile.isEmpty()) {  // Not removed.
+      const QString entryDir =
+          entry.desktopFile.left(entry.desktopFile.lastIndexOf('/'));
+      entries.push_back({entryDirIndices.value(entryDir), &entry});
+    }
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const std::pair<int, const ApplicationEntry*>& e1,
+               const std::pair<int, const ApplicationEntry*>& e2) {
+              return (e1.first != e2.first)
+                  ? e1.first < e2.first
+                  : e1.second->desktopFile < e2.second->desktopFile;
+            });
+
+  applications_.clear();
+  for (const auto& value : entries) {
+    const ApplicationEntry* entry = value.second;
+    auto addKey = [this, entry](const QString& key, ApplicationKey kind) {
+      if (key.isEmpty()) {
+        return;
+      }
+      auto it = applications_.find(key);
+      if (it == applications_.end()) {
+        applications_.insert(key, {entry, kind});
+      } else if (kind <= it->kind) {
+        *it = {entry, kind};
+      }
+    };
+
+    addKey(entry->startupWMClass.toLower(), ApplicationKey::StartupWMClass);
+    // Flatpak entries are launched by 'flatpak run'.
+    if (entry->flatpakAppId.isEmpty()) {
+      addKey(entry->taskCommand.toLower(), ApplicationKey::TaskCommand);
+      addKey(getExecutable(entry->command).toLower(),
+             ApplicationKey::Executable);
+    }
+    addKey(QFileInfo(entry->desktopFile).completeBaseName().toLower(),
+           ApplicationKey::DesktopFileId);
+    addKey(entry->flatpakAppId.toLower(), ApplicationKey::FlatpakAppId);
+  }
 }
 
 void ApplicationMenuConfig::reload() {
+  reloadTimer_.stop();
+  changedEntryDirs_.clear();
+
+  // Executables may have been added, removed or re-linked.
+  TaskCommandCache::clear();
   for (auto& category : categories_) {
     category.entries.clear();
   }
+  applications_.clear();
+  // The consumers hold pointers to the old entries until they have handled
+  // configChanged(), so they are freed only after that.
+  std::deque<ApplicationEntry> oldEntryArena;
+  oldEntryArena.swap(entryArena_);
+  freeEntryIndices_.clear();
+  entryIndices_.clear();
+  strings_.clear();
+  desktopFiles_.clear();
+  if (!indexPath_.isEmpty()) {
+    QFile::remove(indexPath_);
+  }
   loadEntries();
   emit configChanged();
 }
 
-const ApplicationEntry* ApplicationMenuConfig::findApplication(
-    const std::string& command) const {
-  if (command == "systemsettings") {  // Fix for System Settings.
-    return (entries_.count("systemsettings5") > 0) ? entries_.at("systemsettings5") : nullptr;
+void ApplicationMenuConfig::onEntryDirChanged(const QString& entryDir) {
+  if (changedEntryDirs_.isEmpty()) {
+    firstChangeTimer_.start();
+  }
+  changedEntryDirs_.insert(entryDir);
+
+  const int remainingMs =
+      kReloadMaxDelayMs - static_cast<int>(firstChangeTimer_.elapsed());
+  reloadTimer_.start(std::max(0, std::min(kReloadQuietPeriodMs, remainingMs)));
+}
+
+void ApplicationMenuConfig::reloadChangedEntryDirs() {
+  const auto entryDirs = changedEntryDirs_;
+  changedEntryDirs_.clear();
+  reloadEntryDirs(entryDirs);
+}
+
+void ApplicationMenuConfig::reloadEntryDirs(const QSet<QString>& entryDirs) {
+  applyEntryDirChanges(findEntryDirChanges(entryDirs, desktopFiles_));
+}
+
+ApplicationMenuConfig::EntryDirChanges
+ApplicationMenuConfig::findEntryDirChanges(
+    const QSet<QString>& entryDirs, const DesktopFileStates& desktopFiles) {
+  EntryDirChanges changes;
+  ApplicationMenuDelta& delta = changes.delta;
+  for (const auto& entryDir : entryDirs) {
+    auto& states = changes.desktopFiles[entryDir];
+    states = desktopFiles.value(entryDir);
+    QSet<QString> currentFiles;
+    QDir dir(entryDir);
+    for (const auto& fileInfo :
+         dir.entryInfoList({"*.desktop"}, QDir::Files, QDir::Name)) {
+      const QString& fileName = fileInfo.fileName();
+      currentFiles.insert(fileName);
+      const DesktopFileState state =
+          {fileInfo.lastModified(), fileInfo.size()};
+      auto it = states.find(fileName);
+      if (it == states.end()) {
+        delta.addedFiles.append(entryDir + "/" + fileName);
+        states.insert(fileName, state);
+      } else if (it->lastModified != state.lastModified ||
+                 it->size != state.size) {
+        delta.modifiedFiles.append(entryDir + "/" + fileName);
+        *it = state;
+      }
+    }
+    for (auto it = states.begin(); it != states.end();) {
+      if (currentFiles.contains(it.key())) {
+        ++it;
+      } else {
+        delta.removedFiles.append(entryDir + "/" + it.key());
+        it = states.erase(it);
+      }
+    }
   }
-  return (entries_.count(command) > 0) ? entries_.at(command) : nullptr;
+
+  if (changes.isEmpty()) {
+    return changes;
+  }
+
+  // Executables may have been added, removed or re-linked.
+  TaskCommandCache::clear();
+  const QStringList files = delta.addedFiles + delta.modifiedFiles;
+  const auto parsedEntries = parseEntries(files);
+  for (int i = 0; i < parsedEntries.size(); ++i) {
+    if (!parsedEntries[i].categories.isEmpty()) {
+      changes.entries.emplace_back(
+          toApplicationEntry(parsedEntries[i], files[i]),
+          parsedEntries[i].categories);
+    }
+  }
+  return changes;
+}
+
+void ApplicationMenuConfig::applyEntryDirChanges(
+    const EntryDirChanges& changes) {
+  if (changes.isEmpty()) {
+    return;
+  }
+
+  ++loadGeneration_;
+  for (auto it = changes.desktopFiles.begin(); it != changes.desktopFiles.end();
+       ++it) {
+    desktopFiles_[it.key()] = *it;
+  }
+
+  ApplicationMenuDelta delta = changes.delta;
+  std::vector<int> freedIndices;
+  for (const auto& file : delta.removedFiles + delta.modifiedFiles) {
+    const int index = removeEntries(file, &delta.changedCategories);
+    if (index >= 0) {
+      freedIndices.push_back(index);
+    }
+  }
+  for (const auto& entry : changes.entries) {
+    addEntry(entry.first, entry.second, &delta.changedCategories);
+  }
+  pruneStrings();
+  buildIndices();
+  saveIndex();
+  emit entriesChanged(delta);
+  // The consumers no longer hold the removed entries, see entryArena_.
+  freeEntryIndices_.insert(freeEntryIndices_.end(), freedIndices.begin(),
+                           freedIndices.end());
+}
+
+const ApplicationEntry* ApplicationMenuConfig::findApplication(
+    const QString& command) const {
+  const auto it = applications_.constFind(command);
+  return (it != applications_.constEnd()) ? it->entry : nullptr;
 }
 
 }  // namespace ksmoothdock
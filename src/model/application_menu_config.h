@@ -1,18 +1,25 @@
 #ifndef KSMOOTHDOCK_APPLICATION_MENU_CONFIG_H_
 #define KSMOOTHDOCK_APPLICATION_MENU_CONFIG_H_
 
-#include <list>
+#include <deque>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QEvent>
 #include <QFileSystemWatcher>
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QTimer>
 
+#include "application_search_index.h"
 #include <utils/command_utils.h>
 
 namespace ksmoothdock {
@@ -37,11 +44,26 @@ struct ApplicationEntry {
   // The path to the desktop file e.g. '/usr/share/applications/chrome.desktop'
   QString desktopFile;
 
+  // Search keywords e.g. 'Internet', 'WWW'.
+  QStringList keywords;
+
+  // The expected window class e.g. 'code-oss'.
+  QString startupWMClass;
+
+  // The Flatpak application ID e.g. 'org.telegram.desktop'.
+  QString flatpakAppId;
+
   ApplicationEntry(const QString& name2, const QString& genericName2,
                    const QString& icon2, const QString& command2,
                    const QString& desktopFile2)
       : name(name2), genericName(genericName2), icon(icon2), command(command2),
         taskCommand(getTaskCommand(command)), desktopFile(desktopFile2) {}
+
+  ApplicationEntry(const QString& name2, const QString& genericName2,
+                   const QString& icon2, const QString& command2,
+                   const QString& taskCommand2, const QString& desktopFile2)
+      : name(name2), genericName(genericName2), icon(icon2), command(command2),
+        taskCommand(taskCommand2), desktopFile(desktopFile2) {}
 };
 
 bool operator<(const ApplicationEntry &e1, const ApplicationEntry &e2);
@@ -58,70 +80,256 @@ struct Category {
   // Icon name for the category e.g. 'applications-internet'.
   QString icon;
 
-  // Application entries for this category.
-  std::list<ApplicationEntry> entries;
+  // Application entries for this category, sorted by name. No ownership.
+  std::vector<const ApplicationEntry*> entries;
 
   Category(const QString& name2, const QString& displayName2,
            const QString& icon2)
       : name(name2), displayName(displayName2), icon(icon2) {}
 
   Category(const QString& name2, const QString& displayName2,
-           const QString& icon2, std::list<ApplicationEntry> entries2)
+           const QString& icon2, std::vector<const ApplicationEntry*> entries2)
       : name(name2), displayName(displayName2), icon(icon2), entries(entries2) {
   }
 };
 
+// Changes to the application entries after an incremental reload.
+struct ApplicationMenuDelta {
+  // Paths to the desktop files that have been added, modified or removed.
+  QStringList addedFiles;
+  QStringList modifiedFiles;
+  QStringList removedFiles;
+
+  // Names of the categories whose entries have changed.
+  QSet<QString> changedCategories;
+};
+
 class ApplicationMenuConfig : public QObject {
   Q_OBJECT
 
  public:
-  ApplicationMenuConfig(const QStringList& entryDirs = {
-      "/usr/share/applications",
-      "/usr/share/applications/kde4",
-      QDir::homePath() + "/.local/share/applications"});
+  // Args:
+  //   indexPath: path to the persistent application index, or empty if
+  //              the index should not be used.
+  ApplicationMenuConfig(const QStringList& entryDirs = defaultEntryDirs(),
+                        const QString& indexPath = "");
 
   ~ApplicationMenuConfig() = default;
 
   static const std::vector<Category> kSessionSystemCategories;
   static const ApplicationEntry kSearchEntry;
 
+  static QStringList defaultEntryDirs() {
+    return {"/usr/share/applications",
+            "/usr/share/applications/kde4",
+            QDir::homePath() + "/.local/share/applications"};
+  }
+
   const std::vector<Category>& categories() const { return categories_; }
 
-  const ApplicationEntry* findApplication(const std::string& command) const;
-  const ApplicationEntry* findApplication(const QString& command) const {
-    return findApplication(command.toStdString());
+  // Finds the application for a window given its lower-cased window class,
+  // matching the entries' StartupWMClass, task command, executable, desktop
+  // file ID and Flatpak application ID, in that order of precedence.
+  const ApplicationEntry* findApplication(const QString& command) const;
+
+  // Searches for application entries matching the query, best matches first.
+  std::vector<const ApplicationEntry*> searchApplications(
+      const QString& query) const {
+    return searchIndex_.search(query);
   }
 
  signals:
+  // All entries have been reloaded.
   void configChanged();
 
+  // Some entries have been added, modified or removed.
+  void entriesChanged(const ApplicationMenuDelta& delta);
+
  public slots:
+  // Reloads all entries.
   void reload();
 
+ private slots:
+  // Schedules an incremental reload of the entry dir.
+  //
+  // A package upgrade can change hundreds of files in a row, so the changes
+  // are coalesced until the entry dirs have been quiet for
+  // kReloadQuietPeriodMs, or for at most kReloadMaxDelayMs since the first
+  // change, then reloaded in one go.
+  void onEntryDirChanged(const QString& entryDir);
+
+  // Reloads the entry dirs that have changed since the last reload.
+  void reloadChangedEntryDirs();
+
  private:
+  static constexpr int kReloadQuietPeriodMs = 1000;
+  static constexpr int kReloadMaxDelayMs = 5000;
+
+  // The persistent application index's file format.
+  static constexpr quint32 kIndexMagic = 0x4b534449;  // "KSDI"
+  static constexpr quint32 kIndexVersion = 3;
+
+  // Kinds of keys to find applications, in order of precedence.
+  enum class ApplicationKey {
+    StartupWMClass,
+    TaskCommand,
+    Executable,
+    DesktopFileId,
+    FlatpakAppId
+  };
+
+  struct IndexedApplication {
+    const ApplicationEntry* entry;
+    ApplicationKey kind;
+  };
+
+  // The state of a desktop file when it was last loaded.
+  struct DesktopFileState {
+    QDateTime lastModified;
+    qint64 size;
+  };
+
+  using DesktopFileStates = QHash<QString, QHash<QString, DesktopFileState>>;
+
+  // Changes to the entry dirs since the given desktop file states.
+  struct EntryDirChanges {
+    ApplicationMenuDelta delta;
+
+    // The current states of the desktop files in the scanned entry dirs.
+    DesktopFileStates desktopFiles;
+
+    // The entries of the added and modified desktop files with their
+    // categories, in loading order.
+    std::vector<std::pair<ApplicationEntry, QStringList>> entries;
+
+    bool isEmpty() const {
+      return delta.addedFiles.isEmpty() && delta.modifiedFiles.isEmpty() &&
+          delta.removedFiles.isEmpty();
+    }
+  };
+
   // Initializes application categories.
   void initCategories();
 
-  // Loads application entries from entryDir.
+  // Loads application entries from entryDirs_, from the persistent index
+  // if it is up-to-date.
+  //
+  // Otherwise the desktop files are parsed in parallel on the global thread
+  // pool then merged into the categories in order on the calling thread.
   bool loadEntries();
 
-  // Loads an application entry from the .desktop file.
-  bool loadEntry(const QString& file);
+  // Verifies that the entries loaded from the persistent index are still
+  // fresh, as desktop files might have been modified in place, which doesn't
+  // change the entry dirs' modification times.
+  //
+  // The desktop files are checked and parsed on the global thread pool, and
+  // the changes are merged on the calling thread when done.
+  void verifyIndex();
+
+  // The key of the persistent index: the entry dirs, their modification
+  // times and the locale. The index is discarded if the key has changed.
+  QString indexKey() const;
+
+  // The locale that the desktop files' translated names are read in.
+  static QString desktopFileLocale();
+
+  // Loads application entries from the persistent index. Returns false if
+  // there is no index or it is outdated.
+  bool loadIndex();
+
+  // Saves application entries to the persistent index.
+  void saveIndex() const;
+
+  // Loads application entries from the .desktop files.
+  void loadEntries(const QStringList& files,
+                   QSet<QString>* changedCategories = nullptr);
+
+  // Adds an application entry to the given categories.
+  void addEntry(const ApplicationEntry& entry, const QStringList& categories,
+                QSet<QString>* changedCategories = nullptr);
+
+  // Removes the application entries loaded from the .desktop file.
+  //
+  // Returns the index of the cleared arena slot, or -1 if none.
+  int removeEntries(const QString& file, QSet<QString>* changedCategories);
+
+  // Rebuilds the search index and the application index from the entries.
+  void buildIndices();
+
+  // Returns the pooled copy of the string, so that equal strings of different
+  // entries share the same data.
+  QString intern(const QString& s);
+
+  // Removes the strings that are no longer used by any entry from the pool.
+  void pruneStrings();
+
+  // Storage for kSessionSystemCategories's entries.
+  static const std::vector<ApplicationEntry> kSessionSystemEntries;
+
+  // Reloads only the desktop files in the entry dirs that have been added,
+  // modified or removed, based on their modification times and sizes.
+  void reloadEntryDirs(const QSet<QString>& entryDirs);
+
+  // Finds the changes to the entry dirs since the given desktop file states,
+  // and parses the added and modified desktop files.
+  //
+  // Thread-safe, as it is called from the thread pool by verifyIndex().
+  static EntryDirChanges findEntryDirChanges(
+      const QSet<QString>& entryDirs, const DesktopFileStates& desktopFiles);
+
+  // Merges the changes into the entries.
+  void applyEntryDirChanges(const EntryDirChanges& changes);
 
   // The directories that contains the list of all application entries as
   // desktop files, e.g. /usr/share/applications
   const QStringList entryDirs_;
 
+  // The path to the persistent application index.
+  const QString indexPath_;
+
   // Application entries, organized by categories.
   std::vector<Category> categories_;
   // Map from category names to category indices in the above vector,
   // to make loading entries faster.
   std::unordered_map<std::string, int> categoryMap_;
-  // Map from commands to application entries for fast look-up.
-  std::unordered_map<std::string, const ApplicationEntry*> entries_;
+  // Storage for all application entries. Each entry is stored once however
+  // many categories it is in.
+  //
+  // This is a deque rather than a contiguous vector because the categories,
+  // the search index and the docks' programs hold pointers to the entries,
+  // and a deque never moves its elements when it grows. A removed entry is
+  // cleared in place, so a stale pointer sees an empty entry instead of
+  // another application, and its slot is only reused by a later delta, after
+  // the consumers have been told about the removal.
+  std::deque<ApplicationEntry> entryArena_;
+  // Indices of the cleared slots in the arena, for reuse.
+  std::vector<int> freeEntryIndices_;
+  // Map from desktop files to the indices of their entries in the arena.
+  QHash<QString, int> entryIndices_;
+  // Pool of strings shared by the entries e.g. icon names, generic names.
+  QSet<QString> strings_;
+
+  // Map from lower-cased keys to application entries for fast look-up.
+  QHash<QString, IndexedApplication> applications_;
+
+  // Rebuilt whenever the entries change.
+  ApplicationSearchIndex searchIndex_;
+
+  // Map from entry dirs to maps from desktop file names to their states,
+  // to find out which files have changed.
+  DesktopFileStates desktopFiles_;
+
+  // Incremented whenever the entries are (re)loaded, to discard the results
+  // of verifyIndex() that are based on outdated desktop file states.
+  int loadGeneration_;
 
   QFileSystemWatcher fileWatcher_;
 
+  // For coalescing entry dir changes.
+  QSet<QString> changedEntryDirs_;
+  QTimer reloadTimer_;
+  QElapsedTimer firstChangeTimer_;
+
   friend class ApplicationMenuConfigTest;
 };
 
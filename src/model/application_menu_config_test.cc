@@ -20,7 +20,12 @@
 
 #include <memory>
 
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QTemporaryDir>
+#include <QTextStream>
 #include <QTest>
 
 #include <KConfig>
@@ -40,6 +45,16 @@ class ApplicationMenuConfigTest: public QObject {
 
   void loadEntries_singleDir();
   void loadEntries_multipleDirs();
+  void taskCommandCache();
+  void reloadEntryDirs();
+  void reload_oldEntriesValidUntilNotified();
+  void onEntryDirChanged_coalesced();
+  void loadIndex();
+  void verifyIndex();
+  void findApplication();
+
+  // Benchmark with a synthetic directory of 5,000 desktop files.
+  void loadEntries_benchmark();
 
  private:
 
@@ -136,6 +151,347 @@ void ApplicationMenuConfigTest::loadEntries_multipleDirs() {
   }
 }
 
+void ApplicationMenuConfigTest::taskCommandCache() {
+  QTemporaryDir entryDir;
+  QVERIFY(entryDir.isValid());
+  writeEntry(entryDir.path() + "/1.desktop",
+             {"Chrome", "Web Browser", "chrome", "chrome", ""},
+             "Network");
+  writeEntry(entryDir.path() + "/2.desktop",
+             {"Chrome - Incognito", "Web Browser", "chrome",
+              "chrome --incognito", ""},
+             "Network");
+
+  TaskCommandCache::clear();
+  const int lookupCount = TaskCommandCache::lookupCount();
+  ApplicationMenuConfig applicationMenuConfig({ entryDir.path() });
+  QCOMPARE(TaskCommandCache::lookupCount(), lookupCount + 1);
+
+  ApplicationMenuConfig applicationMenuConfig2({ entryDir.path() });
+  QCOMPARE(TaskCommandCache::lookupCount(), lookupCount + 1);
+
+  // Reloading invalidates the cache.
+  applicationMenuConfig.reload();
+  QCOMPARE(TaskCommandCache::lookupCount(), lookupCount + 2);
+}
+
+void ApplicationMenuConfigTest::reloadEntryDirs() {
+  QTemporaryDir entryDir;
+  QVERIFY(entryDir.isValid());
+  writeEntry(entryDir.path() + "/1.desktop",
+             {"Chrome", "Web Browser", "chrome", "chrome", ""},
+             "Network");
+  writeEntry(entryDir.path() + "/2.desktop",
+             {"KMail", "Email Client", "kmail", "kmail", ""},
+             "Network;Office");
+
+  ApplicationMenuConfig applicationMenuConfig({ entryDir.path() });
+  ApplicationMenuDelta delta;
+  int numDeltas = 0;
+  connect(&applicationMenuConfig, &ApplicationMenuConfig::entriesChanged,
+          [&delta, &numDeltas](const ApplicationMenuDelta& d) {
+            delta = d;
+            ++numDeltas;
+          });
+  const auto kmail = applicationMenuConfig.findApplication(QString("kmail"));
+  QVERIFY(kmail != nullptr);
+  QVERIFY(applicationMenuConfig.strings_.contains("Email Client"));
+
+  // Nothing changed.
+  applicationMenuConfig.reloadEntryDirs({ entryDir.path() });
+  QCOMPARE(numDeltas, 0);
+
+  writeEntry(entryDir.path() + "/1.desktop",
+             {"Chrome Stable", "Web Browser", "chrome", "chrome", ""},
+             "Network;Development");
+  QFile::remove(entryDir.path() + "/2.desktop");
+  writeEntry(entryDir.path() + "/3.desktop",
+             {"Kate", "Text Editor", "kate", "kate", ""},
+             "Utility");
+  applicationMenuConfig.reloadEntryDirs({ entryDir.path() });
+
+  QCOMPARE(numDeltas, 1);
+  QCOMPARE(delta.addedFiles, QStringList{entryDir.path() + "/3.desktop"});
+  QCOMPARE(delta.modifiedFiles, QStringList{entryDir.path() + "/1.desktop"});
+  QCOMPARE(delta.removedFiles, QStringList{entryDir.path() + "/2.desktop"});
+  QCOMPARE(delta.changedCategories,
+           QSet<QString>({"Development", "Network", "Office", "Utility"}));
+
+  for (const auto& category : applicationMenuConfig.categories_) {
+    if (category.name == "Network" || category.name == "Development" ||
+        category.name == "Utility") {
+      QCOMPARE(static_cast<int>(category.entries.size()), 1);
+    } else {
+      QCOMPARE(static_cast<int>(category.entries.size()), 0);
+    }
+  }
+
+  QVERIFY(applicationMenuConfig.findApplication(QString("kmail")) == nullptr);
+  QVERIFY(applicationMenuConfig.findApplication(QString("kate")) != nullptr);
+  const auto chrome = applicationMenuConfig.findApplication(QString("chrome"));
+  QVERIFY(chrome != nullptr);
+  QCOMPARE(chrome->name, QString("Chrome Stable"));
+  // The entry is stored once and shared by its categories.
+  for (const auto& category : applicationMenuConfig.categories_) {
+    if (category.name == "Network" || category.name == "Development") {
+      QCOMPARE(category.entries.front(), chrome);
+    }
+  }
+  // Slots are not reused by the same delta, so a stale pointer doesn't alias
+  // another entry.
+  QCOMPARE(static_cast<int>(applicationMenuConfig.entryArena_.size()), 4);
+  QCOMPARE(static_cast<int>(applicationMenuConfig.entryIndices_.size()), 2);
+  QVERIFY(kmail->desktopFile.isEmpty());
+  QVERIFY(kmail != applicationMenuConfig.findApplication(QString("kate")));
+  // The strings of the removed entries are no longer pooled.
+  QVERIFY(!applicationMenuConfig.strings_.contains("Email Client"));
+  QVERIFY(applicationMenuConfig.strings_.contains("Text Editor"));
+
+  // Later deltas reuse the cleared slots, so the arena doesn't grow.
+  writeEntry(entryDir.path() + "/4.desktop",
+             {"Dolphin", "File Manager", "dolphin", "dolphin", ""},
+             "System");
+  applicationMenuConfig.reloadEntryDirs({ entryDir.path() });
+  QCOMPARE(numDeltas, 2);
+  QCOMPARE(static_cast<int>(applicationMenuConfig.entryArena_.size()), 4);
+  QCOMPARE(static_cast<int>(applicationMenuConfig.entryIndices_.size()), 3);
+  QVERIFY(applicationMenuConfig.findApplication(QString("dolphin")) != nullptr);
+}
+
+void ApplicationMenuConfigTest::reload_oldEntriesValidUntilNotified() {
+  QTemporaryDir entryDir;
+  QVERIFY(entryDir.isValid());
+  writeEntry(entryDir.path() + "/1.desktop",
+             {"Chrome", "Web Browser", "chrome", "chrome", ""},
+             "Network");
+
+  ApplicationMenuConfig applicationMenuConfig({ entryDir.path() });
+  const auto chrome = applicationMenuConfig.findApplication(QString("chrome"));
+  QVERIFY(chrome != nullptr);
+  QString nameWhenNotified;
+  connect(&applicationMenuConfig, &ApplicationMenuConfig::configChanged,
+          [chrome, &nameWhenNotified]() { nameWhenNotified = chrome->name; });
+
+  applicationMenuConfig.reload();
+  QCOMPARE(nameWhenNotified, QString("Chrome"));
+  QVERIFY(applicationMenuConfig.findApplication(QString("chrome")) != chrome);
+}
+
+void ApplicationMenuConfigTest::onEntryDirChanged_coalesced() {
+  QTemporaryDir entryDir;
+  QVERIFY(entryDir.isValid());
+
+  ApplicationMenuConfig applicationMenuConfig({ entryDir.path() });
+  ApplicationMenuDelta delta;
+  int numDeltas = 0;
+  connect(&applicationMenuConfig, &ApplicationMenuConfig::entriesChanged,
+          [&delta, &numDeltas](const ApplicationMenuDelta& d) {
+            delta = d;
+            ++numDeltas;
+          });
+
+  // Simulates a burst of changes as in a package upgrade.
+  for (int i = 0; i < 100; ++i) {
+    writeEntry(entryDir.path() + QString("/%1.desktop").arg(i),
+               {"App", "", "app", "app", ""}, "Utility");
+    applicationMenuConfig.onEntryDirChanged(entryDir.path());
+  }
+  QCOMPARE(numDeltas, 0);
+
+  QTRY_COMPARE_WITH_TIMEOUT(
+      numDeltas, 1, ApplicationMenuConfig::kReloadMaxDelayMs + 1000);
+  QCOMPARE(delta.addedFiles.size(), 100);
+  QTest::qWait(ApplicationMenuConfig::kReloadQuietPeriodMs + 500);
+  QCOMPARE(numDeltas, 1);
+}
+
+void ApplicationMenuConfigTest::loadIndex() {
+  QTemporaryDir entryDir;
+  QVERIFY(entryDir.isValid());
+  QTemporaryDir configDir;
+  QVERIFY(configDir.isValid());
+  const QString indexPath = configDir.path() + "/application_index.cache";
+  writeEntry(entryDir.path() + "/1.desktop",
+             {"Chrome", "Web Browser", "chrome", "chrome", ""},
+             "Network");
+  writeEntry(entryDir.path() + "/2.desktop",
+             {"KMail", "Email Client", "kmail", "kmail", ""},
+             "Network;Office");
+
+  {
+    ApplicationMenuConfig applicationMenuConfig({ entryDir.path() }, indexPath);
+    QVERIFY(QFile::exists(indexPath));
+  }
+
+  // Loaded from the index, without parsing the desktop files.
+  TaskCommandCache::clear();
+  const int lookupCount = TaskCommandCache::lookupCount();
+  {
+    ApplicationMenuConfig applicationMenuConfig({ entryDir.path() }, indexPath);
+    QCOMPARE(TaskCommandCache::lookupCount(), lookupCount);
+    for (const auto& category : applicationMenuConfig.categories_) {
+      if (category.name == "Network") {
+        QCOMPARE(static_cast<int>(category.entries.size()), 2);
+      } else if (category.name == "Office") {
+        QCOMPARE(static_cast<int>(category.entries.size()), 1);
+      } else {
+        QCOMPARE(static_cast<int>(category.entries.size()), 0);
+      }
+    }
+    const auto kmail =
+        applicationMenuConfig.findApplication(QString("kmail"));
+    QVERIFY(kmail != nullptr);
+    QCOMPARE(kmail->desktopFile, entryDir.path() + "/2.desktop");
+  }
+
+  // The index is outdated when the entry dir has changed.
+  QTest::qSleep(10);
+  writeEntry(entryDir.path() + "/3.desktop",
+             {"Kate", "Text Editor", "kate", "kate", ""},
+             "Utility");
+  {
+    ApplicationMenuConfig applicationMenuConfig({ entryDir.path() }, indexPath);
+    QVERIFY(TaskCommandCache::lookupCount() > lookupCount);
+    QVERIFY(applicationMenuConfig.findApplication(QString("kate")) != nullptr);
+  }
+}
+
+void ApplicationMenuConfigTest::verifyIndex() {
+  QTemporaryDir entryDir;
+  QVERIFY(entryDir.isValid());
+  QTemporaryDir cacheDir;
+  QVERIFY(cacheDir.isValid());
+  const QString indexPath = cacheDir.path() + "/application_index.cache";
+  const QString desktopFile = entryDir.path() + "/1.desktop";
+  writeEntry(desktopFile, {"Chrome", "Web Browser", "chrome", "chrome", ""},
+             "Network");
+  {
+    ApplicationMenuConfig applicationMenuConfig({ entryDir.path() }, indexPath);
+  }
+
+  // Modifies the desktop file in place, which doesn't change the entry dir's
+  // modification time, so the index is still loaded.
+  const QDateTime dirLastModified = QFileInfo(entryDir.path()).lastModified();
+  const QDateTime lastModified = QFileInfo(desktopFile).lastModified();
+  {
+    QFile file(desktopFile);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QTextStream out(&file);
+    out << "[Desktop Entry]\nName=Chrome Stable\nIcon=chrome\nExec=chrome\n"
+        << "Categories=Network\n";
+    out.flush();
+    QVERIFY(file.setFileTime(lastModified.addSecs(10),
+                             QFileDevice::FileModificationTime));
+  }
+  QCOMPARE(QFileInfo(entryDir.path()).lastModified(), dirLastModified);
+
+  ApplicationMenuConfig applicationMenuConfig({ entryDir.path() }, indexPath);
+  ApplicationMenuDelta delta;
+  int numDeltas = 0;
+  connect(&applicationMenuConfig, &ApplicationMenuConfig::entriesChanged,
+          [&delta, &numDeltas](const ApplicationMenuDelta& d) {
+            delta = d;
+            ++numDeltas;
+          });
+  // Loaded from the index then verified in the background.
+  auto chrome = applicationMenuConfig.findApplication(QString("chrome"));
+  QVERIFY(chrome != nullptr);
+  QCOMPARE(chrome->name, QString("Chrome"));
+
+  QTRY_COMPARE(numDeltas, 1);
+  QCOMPARE(delta.modifiedFiles, QStringList{desktopFile});
+  chrome = applicationMenuConfig.findApplication(QString("chrome"));
+  QVERIFY(chrome != nullptr);
+  QCOMPARE(chrome->name, QString("Chrome Stable"));
+}
+
+void ApplicationMenuConfigTest::findApplication() {
+  QTemporaryDir entryDir1;
+  QVERIFY(entryDir1.isValid());
+  writeEntry(entryDir1.path() + "/code.desktop",
+             {"VS Code", "Text Editor", "code",
+              "/usr/share/code/code --unity-launch", ""},
+             "Development",
+             {{"StartupWMClass", "Code"}});
+  writeEntry(entryDir1.path() + "/org.telegram.desktop.desktop",
+             {"Telegram", "Messenger", "telegram",
+              "/usr/bin/flatpak run --branch=stable org.telegram.desktop",
+              ""},
+             "Network",
+             {{"X-Flatpak", "org.telegram.desktop"}});
+  writeEntry(entryDir1.path() + "/systemsettings.desktop",
+             {"System Settings", "", "preferences-system",
+              "systemsettings5", ""},
+             "Settings");
+  writeEntry(entryDir1.path() + "/kate.desktop",
+             {"Kate", "Text Editor", "kate", "kate -b", ""},
+             "Utility");
+
+  // Overrides kate.desktop in entryDir1.
+  QTemporaryDir entryDir2;
+  QVERIFY(entryDir2.isValid());
+  writeEntry(entryDir2.path() + "/kate.desktop",
+             {"My Kate", "Text Editor", "kate", "kate -b", ""},
+             "Utility");
+
+  ApplicationMenuConfig applicationMenuConfig(
+      { entryDir1.path(), entryDir2.path() });
+
+  // StartupWMClass.
+  auto app = applicationMenuConfig.findApplication(QString("code"));
+  QVERIFY(app != nullptr);
+  QCOMPARE(app->name, QString("VS Code"));
+  // Flatpak application ID.
+  app = applicationMenuConfig.findApplication(QString("org.telegram.desktop"));
+  QVERIFY(app != nullptr);
+  QCOMPARE(app->name, QString("Telegram"));
+  QVERIFY(applicationMenuConfig.findApplication(QString("flatpak")) == nullptr);
+  // Desktop file ID and executable.
+  app = applicationMenuConfig.findApplication(QString("systemsettings"));
+  QVERIFY(app != nullptr);
+  QCOMPARE(app->name, QString("System Settings"));
+  QCOMPARE(applicationMenuConfig.findApplication(QString("systemsettings5")),
+           app);
+  // Later entry dirs take precedence.
+  app = applicationMenuConfig.findApplication(QString("kate"));
+  QVERIFY(app != nullptr);
+  QCOMPARE(app->name, QString("My Kate"));
+
+  QVERIFY(applicationMenuConfig.findApplication(QString("chrome")) == nullptr);
+}
+
+void ApplicationMenuConfigTest::loadEntries_benchmark() {
+  static constexpr int kNumEntries = 5000;
+  static const char* const kCategories[] = {
+    "Development", "Network", "Office", "Utility", "Qt;KDE;Graphics"
+  };
+  QTemporaryDir entryDir;
+  QVERIFY(entryDir.isValid());
+  for (int i = 0; i < kNumEntries; ++i) {
+    // Writes the files directly as KConfig is too slow for this.
+    QFile file(entryDir.path() + QString("/app%1.desktop").arg(i));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    QTextStream out(&file);
+    out << "[Desktop Entry]\n"
+        << "Type=Application\n"
+        << "Name=Application " << i << "\n"
+        << "GenericName=Generic Application " << i << "\n"
+        << "Comment=A synthetic application for benchmarking\n"
+        << "Icon=app" << i << "\n"
+        << "Exec=/usr/bin/app" << i % 500 << " %U\n"
+        << "Categories=" << kCategories[i % 5] << ";\n";
+  }
+
+  QBENCHMARK {
+    ApplicationMenuConfig applicationMenuConfig({ entryDir.path() });
+    int numEntries = 0;
+    for (const auto& category : applicationMenuConfig.categories_) {
+      numEntries += static_cast<int>(category.entries.size());
+    }
+    QCOMPARE(numEntries, kNumEntries);
+  }
+}
+
 }  // namespace ksmoothdock
 
 QTEST_MAIN(ksmoothdock::ApplicationMenuConfigTest)
@@ -0,0 +1,208 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "application_search_index.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include <QFileInfo>
+#include <QSet>
+
+#include "application_menu_config.h"
+
+namespace ksmoothdock {
+
+constexpr int ApplicationSearchIndex::kMaxResults;
+constexpr int ApplicationSearchIndex::kTrigramLength;
+
+void ApplicationSearchIndex::build(const std::vector<Category>& categories) {
+  documents_.clear();
+  trigramIndex_.clear();
+  prefixIndex_.clear();
+  lastQuery_.clear();
+  lastMatches_.clear();
+
+  // An entry appears in all of its categories but is indexed only once.
+  QSet<const ApplicationEntry*> indexedEntries;
+  for (const auto& category : categories) {
+    for (const auto* entry : category.entries) {
+      if (indexedEntries.contains(entry)) {
+        continue;
+      }
+      indexedEntries.insert(entry);
+
+      QString otherFields = entry->genericName;
+      for (const auto& keyword : entry->keywords) {
+        otherFields += "\n" + keyword;
+      }
+      otherFields += "\n" + QFileInfo(entry->desktopFile).completeBaseName();
+      documents_.push_back({entry, entry->name.toLower(),
+                            otherFields.toLower()});
+    }
+  }
+  std::stable_sort(documents_.begin(), documents_.end(),
+                   [](const Document& d1, const Document& d2) {
+                     return d1.name < d2.name;
+                   });
+
+  for (int i = 0; i < size(); ++i) {
+    addTrigrams(i, documents_[i].name);
+    addTrigrams(i, documents_[i].otherFields);
+    addPrefixes(i, documents_[i].name);
+    addPrefixes(i, documents_[i].otherFields);
+  }
+}
+
+std::vector<const ApplicationEntry*> ApplicationSearchIndex::search(
+    const QString& query, int maxResults) const {
+  const QString q = query.trimmed().toLower();
+  if (q.isEmpty()) {
+    lastQuery_.clear();
+    lastMatches_.clear();
+    return {};
+  }
+
+  std::vector<int> candidates;
+  if (q.size() < kTrigramLength) {
+    candidates = prefixIndex_.value(q);
+  } else if (lastQuery_.size() >= kTrigramLength && q.contains(lastQuery_)) {
+    // Anything matching q also matches the last query.
+    candidates = lastMatches_;
+  } else {
+    candidates = findCandidates(q);
+  }
+
+  // Pairs of ranks and document indices.
+  std::vector<std::pair<int, int>> ranked;
+  std::vector<int> matches;
+  for (const int document : candidates) {
+    const int documentRank = rank(document, q);
+    if (documentRank >= 0) {
+      ranked.push_back({documentRank, document});
+      matches.push_back(document);
+    }
+  }
+  lastQuery_ = q;
+  lastMatches_ = std::move(matches);
+
+  // Documents are sorted by name so ties are ordered by name.
+  const int numResults =
+      std::min(maxResults, static_cast<int>(ranked.size()));
+  std::partial_sort(ranked.begin(), ranked.begin() + numResults,
+                    ranked.end());
+  std::vector<const ApplicationEntry*> results;
+  results.reserve(numResults);
+  for (int i = 0; i < numResults; ++i) {
+    results.push_back(documents_[ranked[i].second].entry);
+  }
+  return results;
+}
+
+int ApplicationSearchIndex::find(const QString& text, const QString& query,
+                                 bool* atWordStart) {
+  int first = -1;
+  for (int i = text.indexOf(query); i >= 0; i = text.indexOf(query, i + 1)) {
+    if (i == 0 || !text[i - 1].isLetterOrNumber()) {
+      *atWordStart = true;
+      return i;
+    }
+    if (first < 0) {
+      first = i;
+    }
+  }
+  *atWordStart = false;
+  return first;
+}
+
+int ApplicationSearchIndex::rank(int document, const QString& query) const {
+  // Short queries only match the start of words.
+  const bool wordStartOnly = query.size() < kTrigramLength;
+  const Document& d = documents_[document];
+  bool atWordStart = false;
+  int i = find(d.name, query, &atWordStart);
+  if (i >= 0 && (atWordStart || !wordStartOnly)) {
+    return (i == 0) ? 0 : (atWordStart ? 1 : 2);
+  }
+
+  i = find(d.otherFields, query, &atWordStart);
+  if (i >= 0 && (atWordStart || !wordStartOnly)) {
+    return atWordStart ? 3 : 4;
+  }
+  return -1;
+}
+
+std::vector<int> ApplicationSearchIndex::findCandidates(
+    const QString& query) const {
+  std::vector<const std::vector<int>*> postings;
+  for (int i = 0; i + kTrigramLength <= query.size(); ++i) {
+    const auto it = trigramIndex_.find(trigram(query.constData() + i));
+    if (it == trigramIndex_.end()) {
+      return {};
+    }
+    postings.push_back(&(*it));
+  }
+
+  // Intersects the posting lists, starting from the shortest one.
+  std::sort(postings.begin(), postings.end(),
+            [](const std::vector<int>* p1, const std::vector<int>* p2) {
+              return p1->size() < p2->size();
+            });
+  std::vector<int> candidates = *postings[0];
+  for (size_t i = 1; i < postings.size() && !candidates.empty(); ++i) {
+    std::vector<int> intersection;
+    std::set_intersection(candidates.begin(), candidates.end(),
+                          postings[i]->begin(), postings[i]->end(),
+                          std::back_inserter(intersection));
+    candidates = std::move(intersection);
+  }
+  return candidates;
+}
+
+void ApplicationSearchIndex::addTrigrams(int document, const QString& text) {
+  for (int i = 0; i + kTrigramLength <= text.size(); ++i) {
+    auto& postings = trigramIndex_[trigram(text.constData() + i)];
+    if (postings.empty() || postings.back() != document) {
+      postings.push_back(document);
+    }
+  }
+}
+
+void ApplicationSearchIndex::addPrefixes(int document, const QString& text) {
+  // Words start where find() considers them to, and the prefixes can contain
+  // symbols (e.g. "c+"), so that short queries match the same words as longer
+  // ones. Queries are trimmed, so they never contain leading or trailing
+  // spaces.
+  for (int i = 0; i < text.size(); ++i) {
+    if (i > 0 && text[i - 1].isLetterOrNumber()) {
+      continue;
+    }
+    for (int length = 1; length < kTrigramLength; ++length) {
+      if (i + length > text.size() || text[i + length - 1].isSpace()) {
+        break;
+      }
+      auto& postings = prefixIndex_[text.mid(i, length)];
+      if (postings.empty() || postings.back() != document) {
+        postings.push_back(document);
+      }
+    }
+  }
+}
+
+}  // namespace ksmoothdock
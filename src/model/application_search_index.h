@@ -0,0 +1,109 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KSMOOTHDOCK_APPLICATION_SEARCH_INDEX_H_
+#define KSMOOTHDOCK_APPLICATION_SEARCH_INDEX_H_
+
+#include <vector>
+
+#include <QHash>
+#include <QString>
+
+namespace ksmoothdock {
+
+struct ApplicationEntry;
+struct Category;
+
+// In-memory search index over the application entries.
+//
+// Queries are matched case-insensitively against the entries' names, generic
+// names, keywords and desktop file names. Queries of at least 3 characters
+// match anywhere and are looked up in a trigram index; shorter ones match the
+// start of words and are looked up in a word prefix index. When a query
+// extends the previous one, only the previous matches are re-checked, so
+// typing a query one character at a time stays cheap.
+class ApplicationSearchIndex {
+ public:
+  static constexpr int kMaxResults = 20;
+
+  // Rebuilds the index from the categories' entries. The entries must
+  // outlive the index or the next build.
+  void build(const std::vector<Category>& categories);
+
+  // Searches for entries matching the query, best matches first.
+  //
+  // Entries are ranked by where the query matches: at the start of the name,
+  // at the start of a word in the name, elsewhere in the name, at the start of
+  // a word in the other fields, then elsewhere. Ties are ordered by name.
+  std::vector<const ApplicationEntry*> search(
+      const QString& query, int maxResults = kMaxResults) const;
+
+  // The number of unique entries in the index.
+  int size() const { return static_cast<int>(documents_.size()); }
+
+ private:
+  // Queries shorter than this are matched against word prefixes.
+  static constexpr int kTrigramLength = 3;
+
+  struct Document {
+    const ApplicationEntry* entry;
+    // Lower-cased name.
+    QString name;
+    // Lower-cased generic name, keywords and desktop file name.
+    QString otherFields;
+  };
+
+  static quint64 trigram(const QChar* s) {
+    return (static_cast<quint64>(s[0].unicode()) << 32) |
+        (static_cast<quint64>(s[1].unicode()) << 16) | s[2].unicode();
+  }
+
+  // Returns the index of the first occurrence of query in text at the start
+  // of a word, or the first occurrence anywhere if there is none at the start
+  // of a word (in which case *atWordStart is set to false), or -1.
+  static int find(const QString& text, const QString& query,
+                  bool* atWordStart);
+
+  // Returns the rank of the document for the query, the lower the better,
+  // or -1 if it doesn't match.
+  int rank(int document, const QString& query) const;
+
+  // Finds the documents containing all trigrams of the query.
+  std::vector<int> findCandidates(const QString& query) const;
+
+  void addTrigrams(int document, const QString& text);
+  void addPrefixes(int document, const QString& text);
+
+  // Sorted by name.
+  std::vector<Document> documents_;
+
+  // Map from trigrams to the sorted indices of the documents containing them.
+  QHash<quint64, std::vector<int>> trigramIndex_;
+
+  // Map from word prefixes shorter than kTrigramLength to the sorted indices
+  // of the documents containing them.
+  QHash<QString, std::vector<int>> prefixIndex_;
+
+  // The last query and the documents it matches, for incremental search.
+  mutable QString lastQuery_;
+  mutable std::vector<int> lastMatches_;
+};
+
+}  // namespace ksmoothdock
+
+#endif  // KSMOOTHDOCK_APPLICATION_SEARCH_INDEX_H_
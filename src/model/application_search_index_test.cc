@@ -0,0 +1,215 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "application_search_index.h"
+
+#include <deque>
+#include <vector>
+
+#include <QTest>
+
+#include "application_menu_config.h"
+
+namespace ksmoothdock {
+
+class ApplicationSearchIndexTest: public QObject {
+  Q_OBJECT
+
+ private slots:
+  void init() {
+    entries_.clear();
+    const auto* firefox = createEntry(
+        "Firefox", "Web Browser", "/usr/share/applications/firefox.desktop",
+        {"Internet", "WWW"});
+    std::vector<const ApplicationEntry*> network;
+    network.push_back(firefox);
+    network.push_back(createEntry("Konqueror", "Web Browser",
+                                  "/usr/share/applications/konqueror.desktop"));
+    network.push_back(createEntry(
+        "Thunderbird", "Mail Client",
+        "/usr/share/applications/org.mozilla.thunderbird.desktop"));
+    std::vector<const ApplicationEntry*> system;
+    system.push_back(createEntry("Dolphin", "File Manager",
+                                 "/usr/share/applications/dolphin.desktop"));
+    system.push_back(firefox);
+    system.push_back(createEntry("Profile Cleaner", "",
+                                 "/usr/share/applications/pc.desktop"));
+    categories_.clear();
+    categories_.push_back(Category("Network", "Internet",
+                                   "applications-internet", network));
+    categories_.push_back(Category("System", "System",
+                                   "applications-system", system));
+  }
+
+  void build();
+  void search_shortQuery();
+  // Tests that short queries containing symbols match the same words as the
+  // longer queries they start.
+  void search_shortQuery_symbols();
+  void search_ranking();
+  void search_otherFields();
+  void search_maxResults();
+  void search_incremental();
+
+  // Benchmark with 5,000 synthetic entries, typing a query one character at
+  // a time.
+  void search_benchmark();
+
+ private:
+  const ApplicationEntry* createEntry(const QString& name,
+                                      const QString& genericName,
+                                      const QString& desktopFile,
+                                      const QStringList& keywords = {}) {
+    entries_.emplace_back(name, genericName, "" /* icon */, name.toLower(),
+                          name.toLower(), desktopFile);
+    entries_.back().keywords = keywords;
+    return &entries_.back();
+  }
+
+  QStringList names(const std::vector<const ApplicationEntry*>& entries) {
+    QStringList result;
+    for (const auto* entry : entries) {
+      result.append(entry->name);
+    }
+    return result;
+  }
+
+  std::deque<ApplicationEntry> entries_;
+  std::vector<Category> categories_;
+};
+
+void ApplicationSearchIndexTest::build() {
+  ApplicationSearchIndex index;
+  index.build(categories_);
+  // Firefox is in both categories but only indexed once.
+  QCOMPARE(index.size(), 5);
+  QVERIFY(index.search("").empty());
+  QVERIFY(index.search("  ").empty());
+}
+
+void ApplicationSearchIndexTest::search_shortQuery() {
+  ApplicationSearchIndex index;
+  index.build(categories_);
+  // Short queries only match the start of words.
+  QCOMPARE(names(index.search("f")),
+           QStringList({"Firefox", "Dolphin"}));
+  QCOMPARE(names(index.search("Fi")),
+           QStringList({"Firefox", "Dolphin"}));
+  QCOMPARE(names(index.search("cl")),
+           QStringList({"Profile Cleaner", "Thunderbird"}));
+}
+
+void ApplicationSearchIndexTest::search_shortQuery_symbols() {
+  std::vector<const ApplicationEntry*> development;
+  development.push_back(createEntry(
+      "Qt Creator", "C++ IDE", "/usr/share/applications/qtcreator.desktop"));
+  development.push_back(createEntry("K3b", "Disc Burning",
+                                    "/usr/share/applications/k3b.desktop"));
+  categories_.push_back(Category("Development", "Development",
+                                 "applications-development", development));
+  ApplicationSearchIndex index;
+  index.build(categories_);
+
+  for (const auto& query : {"c", "c+", "c++", "+"}) {
+    QVERIFY(names(index.search(query)).contains("Qt Creator"));
+  }
+  for (const auto& query : {"k3", "k3b"}) {
+    QCOMPARE(names(index.search(query)), QStringList({"K3b"}));
+  }
+}
+
+void ApplicationSearchIndexTest::search_ranking() {
+  ApplicationSearchIndex index;
+  index.build(categories_);
+  // Name prefix, then inside the name, then the start of a word in the other
+  // fields.
+  QCOMPARE(names(index.search("fil")),
+           QStringList({"Profile Cleaner", "Dolphin"}));
+  QCOMPARE(names(index.search("FIRE")), QStringList({"Firefox"}));
+  QCOMPARE(names(index.search("clea")),
+           QStringList({"Profile Cleaner"}));
+  QVERIFY(index.search("chrome").empty());
+}
+
+void ApplicationSearchIndexTest::search_otherFields() {
+  ApplicationSearchIndex index;
+  index.build(categories_);
+  // Generic names, ordered by name.
+  QCOMPARE(names(index.search("web")),
+           QStringList({"Firefox", "Konqueror"}));
+  // Keywords.
+  QCOMPARE(names(index.search("www")), QStringList({"Firefox"}));
+  // Desktop file names.
+  QCOMPARE(names(index.search("mozilla")), QStringList({"Thunderbird"}));
+}
+
+void ApplicationSearchIndexTest::search_maxResults() {
+  ApplicationSearchIndex index;
+  index.build(categories_);
+  QCOMPARE(names(index.search("web", 1)), QStringList({"Firefox"}));
+}
+
+void ApplicationSearchIndexTest::search_incremental() {
+  ApplicationSearchIndex index;
+  index.build(categories_);
+  const QStringList queries = {"t", "th", "thu", "thun", "hun", "bird",
+                               "birds", "bro", "brow", "r", "er"};
+  for (const auto& query : queries) {
+    ApplicationSearchIndex freshIndex;
+    freshIndex.build(categories_);
+    QCOMPARE(names(index.search(query)), names(freshIndex.search(query)));
+  }
+}
+
+void ApplicationSearchIndexTest::search_benchmark() {
+  static constexpr int kNumEntries = 5000;
+  static const char* const kWords[] = {
+      "Audio", "Browser", "Calendar", "Disk", "Editor", "File", "Graph",
+      "Image", "Mail", "Music", "Network", "Office", "Player", "Terminal",
+      "Video", "Viewer"};
+  static constexpr int kNumWords = sizeof(kWords) / sizeof(kWords[0]);
+  std::vector<const ApplicationEntry*> entries;
+  for (int i = 0; i < kNumEntries; ++i) {
+    const QString name = QString("%1 %2 %3")
+        .arg(QString(kWords[i % kNumWords]),
+             QString(kWords[(i / kNumWords) % kNumWords]))
+        .arg(i);
+    entries.push_back(createEntry(
+        name, kWords[(i * 7) % kNumWords],
+        QString("/usr/share/applications/app%1.desktop").arg(i)));
+  }
+  std::vector<Category> categories;
+  categories.push_back(Category("Utility", "Utilities",
+                                "applications-utilities", entries));
+  ApplicationSearchIndex index;
+  index.build(categories);
+  QCOMPARE(index.size(), kNumEntries);
+
+  const QString query = "video player 42";
+  QBENCHMARK {
+    for (int i = 1; i <= query.size(); ++i) {
+      index.search(query.left(i));
+    }
+  }
+  QVERIFY(!index.search("player").empty());
+}
+
+}  // namespace ksmoothdock
+
+QTEST_MAIN(ksmoothdock::ApplicationSearchIndexTest)
+#include "application_search_index_test.moc"
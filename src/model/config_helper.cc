@@ -30,12 +30,18 @@ constexpr char ConfigHelper::kSingleDockLaunchers[];
 constexpr char ConfigHelper::kConfigPattern[];
 constexpr char ConfigHelper::kAppearanceConfig[];
 constexpr char ConfigHelper::kIconOverrideRules[];
+constexpr char ConfigHelper::kApplicationIndex[];
+constexpr char ConfigHelper::kWallpaperThumbnails[];
 
-ConfigHelper::ConfigHelper(const QString& configDir)
-    : configDir_{configDir} {
+ConfigHelper::ConfigHelper(const QString& configDir, const QString& cacheDir)
+    : configDir_{configDir},
+      cacheDir_{cacheDir} {
   if (!configDir_.exists()) {
     QDir::root().mkpath(configDir);
   }
+  if (!cacheDir_.exists()) {
+    QDir::root().mkpath(cacheDir);
+  }
 }
 
 std::vector<std::tuple<QString, QString>> ConfigHelper::findAllDockConfigs()
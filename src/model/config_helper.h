@@ -23,6 +23,7 @@
 #include <vector>
 
 #include <QDir>
+#include <QString>
 
 namespace ksmoothdock {
 
@@ -45,7 +46,16 @@ class ConfigHelper  {
   // Global icon override rules (for task manager).
   static constexpr char kIconOverrideRules[] = "icon_override.rules";
 
-  explicit ConfigHelper(const QString& configDir);
+  // Persistent index of the application menu's entries.
+  static constexpr char kApplicationIndex[] = "application_index.cache";
+
+  // On-disk cache of the pager's wallpaper thumbnails.
+  static constexpr char kWallpaperThumbnails[] = "wallpaper_thumbnails";
+
+  // Args:
+  //   cacheDir: the directory for regenerable caches e.g. the application
+  //             index and the wallpaper thumbnails.
+  ConfigHelper(const QString& configDir, const QString& cacheDir);
   ~ConfigHelper() = default;
 
   // Gets the appearance config file path.
@@ -58,6 +68,16 @@ class ConfigHelper  {
     return configDir_.filePath(kIconOverrideRules);
   }
 
+  // Gets the application index file path.
+  QString applicationIndexPath() const {
+    return cacheDir_.filePath(kApplicationIndex);
+  }
+
+  // Gets the wallpaper thumbnail cache directory path.
+  QString wallpaperThumbnailsPath() const {
+    return cacheDir_.filePath(kWallpaperThumbnails);
+  }
+
   static QString wallpaperConfigKey(int desktop, int screen) {
     // Screen is 0-based.
     return QString("wallpaper") + QString::number(desktop) +
@@ -139,6 +159,7 @@ class ConfigHelper  {
   }
 
   QDir configDir_;
+  QDir cacheDir_;
 
   friend class MultiDockModelTest;
 };
@@ -0,0 +1,217 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "icon_override_rules.h"
+
+#include <climits>
+#include <iostream>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QStringView>
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KDesktopFile>
+
+#include <utils/command_utils.h>
+
+namespace ksmoothdock {
+
+IconOverrideRules::IconOverrideRules(const QString& rulesPath)
+    : rulesPath_(rulesPath) {
+  compile();
+
+  // Also watches the config dir, as the rules file might not exist yet or
+  // might be replaced when saved.
+  fileWatcher_.addPath(QFileInfo(rulesPath_).absolutePath());
+  watchRulesFile();
+  connect(&fileWatcher_, SIGNAL(directoryChanged(const QString&)),
+          this, SLOT(reload()));
+  connect(&fileWatcher_, SIGNAL(fileChanged(const QString&)),
+          this, SLOT(reload()));
+}
+
+const IconOverrideRule* IconOverrideRules::findRule(
+    const QString& windowClass, const QString& title,
+    const QString& taskCommand) const {
+  if (rules_.empty()) {
+    return nullptr;
+  }
+
+  const QString key = windowClass.toLower();
+  int best = INT_MAX;
+  auto it = windowClassIndex_.constFind(key);
+  if (it != windowClassIndex_.constEnd()) {
+    findRule(*it, key, title, taskCommand, &best);
+  }
+  for (int length : prefixLengths_) {
+    if (length > key.size()) {
+      continue;
+    }
+    it = windowClassPrefixIndex_.constFind(key.left(length));
+    if (it != windowClassPrefixIndex_.constEnd()) {
+      findRule(*it, key, title, taskCommand, &best);
+    }
+  }
+  it = taskCommandIndex_.constFind(taskCommand);
+  if (it != taskCommandIndex_.constEnd()) {
+    findRule(*it, key, title, taskCommand, &best);
+  }
+  findRule(titleRules_, key, title, taskCommand, &best);
+
+  return (best < INT_MAX) ? &rules_[best] : nullptr;
+}
+
+void IconOverrideRules::reload() {
+  const QFileInfo info(rulesPath_);
+  const QDateTime lastModified =
+      info.exists() ? info.lastModified() : QDateTime();
+  if (lastModified == lastModified_) {
+    return;
+  }
+
+  compile();
+  watchRulesFile();
+  emit rulesChanged();
+}
+
+void IconOverrideRules::compile() {
+  rules_.clear();
+  windowClassIndex_.clear();
+  windowClassPrefixIndex_.clear();
+  taskCommandIndex_.clear();
+  titleRules_.clear();
+  prefixLengths_.clear();
+
+  const QFileInfo info(rulesPath_);
+  lastModified_ = info.exists() ? info.lastModified() : QDateTime();
+  if (!info.exists()) {
+    return;
+  }
+
+  KConfig config(rulesPath_, KConfig::SimpleConfig);
+  QStringList groups = config.groupList();
+  groups.sort();
+  for (const auto& group : groups) {
+    KConfigGroup configGroup(&config, group);
+    IconOverrideRule rule;
+    rule.windowClass =
+        configGroup.readEntry("windowClass", QString()).toLower();
+    rule.taskCommand = configGroup.readEntry("taskCommand", QString());
+    const QString title = configGroup.readEntry("title", QString());
+    if (rule.windowClass.isEmpty() && rule.taskCommand.isEmpty() &&
+        title.isEmpty()) {
+      std::cerr << "Icon override rule without conditions: "
+                << group.toStdString() << std::endl;
+      continue;
+    }
+
+    if (!title.isEmpty()) {
+      // The title pattern has to match the whole title.
+      rule.title.setPattern("\\A(?:" + title + ")\\z");
+      if (!rule.title.isValid()) {
+        std::cerr << "Invalid title pattern in icon override rule: "
+                  << group.toStdString() << std::endl;
+        continue;
+      }
+      rule.title.optimize();
+    }
+
+    rule.icon = configGroup.readEntry("icon", QString());
+    rule.desktopFile = configGroup.readEntry("desktopFile", QString());
+    if (!rule.desktopFile.isEmpty()) {
+      if (!QFile::exists(rule.desktopFile)) {
+        std::cerr << "Desktop file not found for icon override rule: "
+                  << group.toStdString() << std::endl;
+        continue;
+      }
+
+      KDesktopFile desktopFile(rule.desktopFile);
+      rule.name = desktopFile.readName();
+      rule.command = filterFieldCodes(
+          desktopFile.entryMap("Desktop Entry")["Exec"]);
+      if (rule.icon.isEmpty()) {
+        rule.icon = desktopFile.readIcon();
+      }
+    }
+    if (rule.icon.isEmpty()) {
+      std::cerr << "Icon override rule without icon: "
+                << group.toStdString() << std::endl;
+      continue;
+    }
+
+    // Each rule is indexed on its most selective condition only.
+    const int index = static_cast<int>(rules_.size());
+    if (rule.windowClass.endsWith('*')) {
+      const QString prefix = rule.windowClass.chopped(1);
+      windowClassPrefixIndex_[prefix].push_back(index);
+      if (!prefixLengths_.contains(prefix.size())) {
+        prefixLengths_.push_back(prefix.size());
+      }
+    } else if (!rule.windowClass.isEmpty()) {
+      windowClassIndex_[rule.windowClass].push_back(index);
+    } else if (!rule.taskCommand.isEmpty()) {
+      taskCommandIndex_[rule.taskCommand].push_back(index);
+    } else {
+      titleRules_.push_back(index);
+    }
+    rules_.push_back(std::move(rule));
+  }
+}
+
+void IconOverrideRules::watchRulesFile() {
+  if (QFile::exists(rulesPath_) && !fileWatcher_.files().contains(rulesPath_)) {
+    fileWatcher_.addPath(rulesPath_);
+  }
+}
+
+bool IconOverrideRules::matches(
+    const IconOverrideRule& rule, const QString& windowClass,
+    const QString& title, const QString& taskCommand) const {
+  if (rule.windowClass.endsWith('*')) {
+    if (!windowClass.startsWith(QStringView(rule.windowClass).chopped(1))) {
+      return false;
+    }
+  } else if (!rule.windowClass.isEmpty() && rule.windowClass != windowClass) {
+    return false;
+  }
+
+  if (!rule.taskCommand.isEmpty() && rule.taskCommand != taskCommand) {
+    return false;
+  }
+
+  return rule.title.pattern().isEmpty() || rule.title.match(title).hasMatch();
+}
+
+void IconOverrideRules::findRule(
+    const QVector<int>& indices, const QString& windowClass,
+    const QString& title, const QString& taskCommand, int* best) const {
+  for (int index : indices) {
+    if (index >= *best) {
+      return;
+    }
+    if (matches(rules_[index], windowClass, title, taskCommand)) {
+      *best = index;
+      return;
+    }
+  }
+}
+
+}  // namespace ksmoothdock
@@ -0,0 +1,146 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KSMOOTHDOCK_ICON_OVERRIDE_RULES_H_
+#define KSMOOTHDOCK_ICON_OVERRIDE_RULES_H_
+
+#include <vector>
+
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+namespace ksmoothdock {
+
+// An icon override rule for the task manager.
+struct IconOverrideRule {
+  // Conditions. Empty ones are ignored but at least one must be specified.
+
+  // The window class to match (case-insensitive), e.g. 'jetbrains-idea'.
+  // A trailing '*' matches all window classes with the given prefix,
+  // e.g. 'jetbrains-*'.
+  QString windowClass;
+
+  // The task command to match, e.g. 'java'.
+  QString taskCommand;
+
+  // The pattern to match against the window title e.g. '.*IntelliJ IDEA.*'.
+  QRegularExpression title;
+
+  // Results.
+
+  // Icon name e.g. 'idea'.
+  QString icon;
+
+  // The path to the desktop file e.g. '/usr/share/applications/idea.desktop'.
+  // If specified, the name, command and icon (unless overridden) are taken
+  // from the desktop file.
+  QString desktopFile;
+
+  // Name e.g. 'IntelliJ IDEA'.
+  QString name;
+
+  // Command to execute e.g. '/opt/idea/bin/idea.sh'.
+  QString command;
+};
+
+// The icon override rules for windows of applications that are not in the
+// application menu, which would otherwise show a generic icon.
+//
+// The rules are loaded from ConfigHelper::kIconOverrideRules, one group per
+// rule e.g.
+//
+//   [Rule 01]
+//   windowClass=jetbrains-*
+//   title=.*IntelliJ IDEA.*
+//   icon=idea
+//
+//   [Rule 02]
+//   taskCommand=java
+//   desktopFile=/usr/share/applications/netbeans.desktop
+//
+// A rule matches if all its specified conditions match. Rules are evaluated
+// in the order of their group names and the first matching rule wins.
+//
+// The rules are compiled once into hash indices on window class, window class
+// prefix and task command, with precompiled title patterns, so that finding
+// the rule for a window only takes a few hash look-ups. The compiled rules are
+// kept until the rules file changes.
+class IconOverrideRules : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit IconOverrideRules(const QString& rulesPath);
+  ~IconOverrideRules() = default;
+
+  // Finds the first rule that matches the window, or nullptr if none does.
+  const IconOverrideRule* findRule(const QString& windowClass,
+                                   const QString& title,
+                                   const QString& taskCommand) const;
+
+  int ruleCount() const { return static_cast<int>(rules_.size()); }
+
+ signals:
+  void rulesChanged();
+
+ public slots:
+  // Recompiles the rules if the rules file has changed.
+  void reload();
+
+ private:
+  // Compiles the rules from the rules file.
+  void compile();
+
+  // Watches the rules file, which may be (re)created by editors.
+  void watchRulesFile();
+
+  bool matches(const IconOverrideRule& rule, const QString& windowClass,
+               const QString& title, const QString& taskCommand) const;
+
+  // Finds the first matching rule in the (sorted) rule indices that comes
+  // before the current best match.
+  void findRule(const QVector<int>& indices, const QString& windowClass,
+                const QString& title, const QString& taskCommand,
+                int* best) const;
+
+  const QString rulesPath_;
+  QDateTime lastModified_;
+
+  std::vector<IconOverrideRule> rules_;
+
+  // Indices into rules_, each sorted.
+  QHash<QString, QVector<int>> windowClassIndex_;
+  QHash<QString, QVector<int>> windowClassPrefixIndex_;
+  QHash<QString, QVector<int>> taskCommandIndex_;
+  // Rules with only the title condition.
+  QVector<int> titleRules_;
+  // Distinct lengths of the window class prefixes.
+  QVector<int> prefixLengths_;
+
+  QFileSystemWatcher fileWatcher_;
+
+  friend class IconOverrideRulesTest;
+};
+
+}  // namespace ksmoothdock
+
+#endif  // KSMOOTHDOCK_ICON_OVERRIDE_RULES_H_
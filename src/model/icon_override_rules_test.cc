@@ -0,0 +1,186 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "icon_override_rules.h"
+
+#include <string>
+#include <unordered_map>
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <KConfig>
+#include <KConfigGroup>
+
+namespace ksmoothdock {
+
+class IconOverrideRulesTest: public QObject {
+  Q_OBJECT
+
+ private slots:
+  void findRule_noRulesFile();
+  void findRule_windowClass();
+  void findRule_taskCommandAndTitle();
+  void findRule_desktopFile();
+  void reload();
+
+ private:
+  void writeRule(const QString& filename, const QString& rule,
+                 const std::unordered_map<std::string, std::string>& kvs) {
+    KConfig config(filename, KConfig::SimpleConfig);
+    KConfigGroup group(&config, rule);
+    for (const auto& kv : kvs) {
+      group.writeEntry(QString::fromStdString(kv.first),
+                       QString::fromStdString(kv.second));
+    }
+    config.sync();
+  }
+
+  // Sets the file's modification time explicitly, so that the change is seen
+  // even on file systems with coarse modification times.
+  void touch(const QString& filename, const QDateTime& lastModified) {
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(lastModified, QFileDevice::FileModificationTime));
+  }
+};
+
+void IconOverrideRulesTest::findRule_noRulesFile() {
+  QTemporaryDir configDir;
+  QVERIFY(configDir.isValid());
+
+  IconOverrideRules rules(configDir.path() + "/icon_override.rules");
+  QCOMPARE(rules.ruleCount(), 0);
+  QVERIFY(rules.findRule("jetbrains-idea", "", "jetbrains-idea") == nullptr);
+}
+
+void IconOverrideRulesTest::findRule_windowClass() {
+  QTemporaryDir configDir;
+  QVERIFY(configDir.isValid());
+  const QString rulesPath = configDir.path() + "/icon_override.rules";
+  writeRule(rulesPath, "Rule 01",
+            {{"windowClass", "jetbrains-idea"}, {"icon", "idea"}});
+  writeRule(rulesPath, "Rule 02",
+            {{"windowClass", "jetbrains-*"}, {"icon", "jetbrains"}});
+  writeRule(rulesPath, "Rule 03", {{"windowClass", "no-icon"}});
+
+  IconOverrideRules rules(rulesPath);
+  QCOMPARE(rules.ruleCount(), 2);
+
+  auto rule = rules.findRule("JetBrains-IDEA", "", "jetbrains-idea");
+  QVERIFY(rule != nullptr);
+  QCOMPARE(rule->icon, QString("idea"));
+
+  rule = rules.findRule("jetbrains-clion", "", "jetbrains-clion");
+  QVERIFY(rule != nullptr);
+  QCOMPARE(rule->icon, QString("jetbrains"));
+
+  QVERIFY(rules.findRule("jetbrains", "", "jetbrains") == nullptr);
+  QVERIFY(rules.findRule("no-icon", "", "no-icon") == nullptr);
+}
+
+void IconOverrideRulesTest::findRule_taskCommandAndTitle() {
+  QTemporaryDir configDir;
+  QVERIFY(configDir.isValid());
+  const QString rulesPath = configDir.path() + "/icon_override.rules";
+  writeRule(rulesPath, "Rule 01",
+            {{"taskCommand", "java"}, {"title", ".*NetBeans.*"},
+             {"icon", "netbeans"}});
+  writeRule(rulesPath, "Rule 02", {{"taskCommand", "java"}, {"icon", "java"}});
+  writeRule(rulesPath, "Rule 03",
+            {{"title", "Steam"}, {"icon", "steam"}});
+
+  IconOverrideRules rules(rulesPath);
+  QCOMPARE(rules.ruleCount(), 3);
+
+  auto rule = rules.findRule("sun-awt-X11-XFramePeer", "Apache NetBeans IDE",
+                             "java");
+  QVERIFY(rule != nullptr);
+  QCOMPARE(rule->icon, QString("netbeans"));
+
+  rule = rules.findRule("sun-awt-X11-XFramePeer", "Some Java App", "java");
+  QVERIFY(rule != nullptr);
+  QCOMPARE(rule->icon, QString("java"));
+
+  rule = rules.findRule("", "Steam", "");
+  QVERIFY(rule != nullptr);
+  QCOMPARE(rule->icon, QString("steam"));
+
+  // The title pattern has to match the whole title.
+  QVERIFY(rules.findRule("", "Steam - News", "") == nullptr);
+}
+
+void IconOverrideRulesTest::findRule_desktopFile() {
+  QTemporaryDir configDir;
+  QVERIFY(configDir.isValid());
+  const QString desktopFile = configDir.path() + "/netbeans.desktop";
+  {
+    KConfig config(desktopFile, KConfig::SimpleConfig);
+    KConfigGroup group(&config, "Desktop Entry");
+    group.writeEntry("Name", "NetBeans");
+    group.writeEntry("Icon", "netbeans");
+    group.writeEntry("Exec", "netbeans %U");
+    config.sync();
+  }
+  const QString rulesPath = configDir.path() + "/icon_override.rules";
+  writeRule(rulesPath, "Rule 01",
+            {{"taskCommand", "java"},
+             {"desktopFile", desktopFile.toStdString()}});
+
+  IconOverrideRules rules(rulesPath);
+  auto rule = rules.findRule("sun-awt-X11-XFramePeer", "", "java");
+  QVERIFY(rule != nullptr);
+  QCOMPARE(rule->name, QString("NetBeans"));
+  QCOMPARE(rule->icon, QString("netbeans"));
+  QCOMPARE(rule->command, QString("netbeans"));
+}
+
+void IconOverrideRulesTest::reload() {
+  QTemporaryDir configDir;
+  QVERIFY(configDir.isValid());
+  const QString rulesPath = configDir.path() + "/icon_override.rules";
+  writeRule(rulesPath, "Rule 01",
+            {{"windowClass", "jetbrains-idea"}, {"icon", "idea"}});
+
+  IconOverrideRules rules(rulesPath);
+  QCOMPARE(rules.ruleCount(), 1);
+  QSignalSpy spy(&rules, SIGNAL(rulesChanged()));
+
+  // Not changed.
+  rules.reload();
+  QCOMPARE(rules.ruleCount(), 1);
+  QCOMPARE(spy.count(), 0);
+
+  const QDateTime lastModified = QFileInfo(rulesPath).lastModified();
+  writeRule(rulesPath, "Rule 02",
+            {{"windowClass", "jetbrains-*"}, {"icon", "jetbrains"}});
+  touch(rulesPath, lastModified.addSecs(10));
+  rules.reload();
+  QCOMPARE(rules.ruleCount(), 2);
+  QCOMPARE(spy.count(), 1);
+  QVERIFY(rules.findRule("jetbrains-clion", "", "") != nullptr);
+}
+
+}  // namespace ksmoothdock
+
+QTEST_MAIN(ksmoothdock::IconOverrideRulesTest)
+#include "icon_override_rules_test.moc"
@@ -77,16 +77,24 @@ void LauncherConfig::saveToFile(const QString &filePath) const {
   config.sync();
 }
 
-MultiDockModel::MultiDockModel(const QString& configDir)
-    : configHelper_(configDir),
+MultiDockModel::MultiDockModel(const QString& configDir,
+                               const QString& cacheDir)
+    : configHelper_(configDir, cacheDir),
       appearanceConfig_(configHelper_.appearanceConfigPath(),
-                        KConfig::SimpleConfig) {
+                        KConfig::SimpleConfig),
+      applicationMenuConfig_(ApplicationMenuConfig::defaultEntryDirs(),
+                             configHelper_.applicationIndexPath()),
+      iconOverrideRules_(configHelper_.iconOverrideRulesPath()) {
   if (convertConfig()) {
     appearanceConfig_.reparseConfiguration();
   }
   loadDocks();
   connect(&applicationMenuConfig_, SIGNAL(configChanged()),
           this, SIGNAL(applicationMenuConfigChanged()));
+  connect(&applicationMenuConfig_, &ApplicationMenuConfig::entriesChanged,
+          this, &MultiDockModel::applicationMenuEntriesChanged);
+  connect(&iconOverrideRules_, SIGNAL(rulesChanged()),
+          this, SIGNAL(iconOverrideRulesChanged()));
 }
 
 void MultiDockModel::loadDocks() {
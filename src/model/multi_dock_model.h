@@ -35,6 +35,7 @@
 
 #include "application_menu_config.h"
 #include "config_helper.h"
+#include "icon_override_rules.h"
 #include <utils/command_utils.h>
 
 namespace ksmoothdock {
@@ -94,7 +95,10 @@ class MultiDockModel : public QObject {
   Q_OBJECT
 
  public:
-  MultiDockModel(const QString& configDir);
+  // Args:
+  //   cacheDir: the directory for regenerable caches, e.g. the XDG cache
+  //             directory of the application.
+  MultiDockModel(const QString& configDir, const QString& cacheDir);
   ~MultiDockModel() = default;
 
   MultiDockModel(const MultiDockModel&) = delete;
@@ -220,6 +224,11 @@ class MultiDockModel : public QObject {
                           value);
   }
 
+  // Gets the directory of the on-disk wallpaper thumbnail cache.
+  QString wallpaperThumbnailsPath() const {
+    return configHelper_.wallpaperThumbnailsPath();
+  }
+
   // Notifies that the wallpaper for the current desktop for the specified
   // screen has been changed.
   void notifyWallpaperChanged(int screen) {
@@ -420,6 +429,19 @@ class MultiDockModel : public QObject {
     return applicationMenuConfig_.findApplication(command);
   }
 
+  std::vector<const ApplicationEntry*> searchApplications(
+      const QString& query) const {
+    return applicationMenuConfig_.searchApplications(query);
+  }
+
+  // Finds the icon override rule for a window whose application is not found
+  // by findApplication().
+  const IconOverrideRule* findIconOverrideRule(
+      const QString& windowClass, const QString& title,
+      const QString& taskCommand) const {
+    return iconOverrideRules_.findRule(windowClass, title, taskCommand);
+  }
+
  signals:
   // Minor appearance changes that require view update (repaint).
   void appearanceOutdated();
@@ -431,6 +453,10 @@ class MultiDockModel : public QObject {
   // Will require calling Plasma D-Bus to update the wallpaper.
   void wallpaperChanged(int screen);
   void applicationMenuConfigChanged();
+  void applicationMenuEntriesChanged(const ApplicationMenuDelta& delta);
+  // The icon override rules have been recompiled. Tasks need to be
+  // re-resolved.
+  void iconOverrideRulesChanged();
 
  private:
   // Dock config's categories/properties.
@@ -561,6 +587,8 @@ class MultiDockModel : public QObject {
   int nextDockId_;
 
   ApplicationMenuConfig applicationMenuConfig_;
+
+  IconOverrideRules iconOverrideRules_;
 };
 
 }  // namespace ksmoothdock
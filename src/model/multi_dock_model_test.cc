@@ -44,27 +44,30 @@ class MultiDockModelTest: public QObject {
 
 void MultiDockModelTest::load_noDock() {
   QTemporaryDir configDir;
-  MultiDockModel model(configDir.path());
+  QTemporaryDir cacheDir;
+  MultiDockModel model(configDir.path(), cacheDir.path());
   QCOMPARE(model.dockCount(), 0);
 }
 
 void MultiDockModelTest::load_singleDock() {
   QTemporaryDir configDir;
+  QTemporaryDir cacheDir;
   QVERIFY(configDir.isValid());
   createDockConfig(configDir, 1);
 
-  MultiDockModel model(configDir.path());
+  MultiDockModel model(configDir.path(), cacheDir.path());
   QCOMPARE(model.dockCount(), 1);
 }
 
 void MultiDockModelTest::load_multipleDocks() {
   QTemporaryDir configDir;
+  QTemporaryDir cacheDir;
   QVERIFY(configDir.isValid());
   createDockConfig(configDir, 1);
   createDockConfig(configDir, 2);
   createDockConfig(configDir, 4);
 
-  MultiDockModel model(configDir.path());
+  MultiDockModel model(configDir.path(), cacheDir.path());
   QCOMPARE(model.dockCount(), 3);
 }
 
@@ -19,9 +19,14 @@
 #ifndef KSMOOTHDOCK_COMMAND_UTILS_H_
 #define KSMOOTHDOCK_COMMAND_UTILS_H_
 
+#include <atomic>
 #include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 #include <QString>
+#include <QStringList>
 
 namespace ksmoothdock {
 
@@ -48,16 +53,87 @@ inline bool isCommandLockScreen(const QString& command) {
   return command == kLockScreenCommand;
 }
 
-inline std::string getTaskCommand(const std::string& appCommand) {
-  namespace fs = std::filesystem;
-  const auto command = appCommand.substr(0, appCommand.find_first_of(' '));
-  return fs::is_symlink(command) ?
-      fs::path(fs::read_symlink(command)).filename() :
-      fs::path(command).filename();
+// Gets the path to the executable of the command, skipping the 'env' wrapper
+// with its options and environment variables, e.g. '/usr/bin/firefox' for
+// 'env MOZ_ENABLE_WAYLAND=1 /usr/bin/firefox --new-window'.
+inline QString getExecutablePath(const QString& command) {
+  const QStringList args = command.split(' ', Qt::SkipEmptyParts);
+  int i = 0;
+  if (!args.isEmpty() && args[0].section('/', -1) == "env") {
+    for (i = 1; i < args.size(); ++i) {
+      if (args[i] == "-u" || args[i] == "-C") {
+        ++i;  // Skips the option's argument too.
+      } else if (!args[i].startsWith('-') && !args[i].contains('=')) {
+        break;
+      }
+    }
+  }
+  return (i < args.size()) ? args[i] : QString();
+}
+
+// Gets the file name of the executable of the command e.g. 'firefox'.
+inline QString getExecutable(const QString& command) {
+  return getExecutablePath(command).section('/', -1);
 }
 
+// Process-wide cache of task commands, keyed by the executable part of the
+// app command.
+//
+// Resolving a task command requires stat/readlink calls on the executable,
+// and the same executables are resolved over and over again (application
+// menu scans, launcher reloads) so we only do it once per executable.
+// The cache is cleared when the application directories change.
+//
+// Thread-safe, as desktop files are parsed concurrently.
+class TaskCommandCache {
+ public:
+  static std::string get(const std::string& command) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto it = cache_.find(command);
+      if (it != cache_.end()) {
+        return it->second;
+      }
+    }
+
+    // Resolves outside the lock so that concurrent look-ups of different
+    // executables don't wait for each other's file system calls. Two threads
+    // might resolve the same executable, with the same result.
+    const std::string taskCommand = resolve(command);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_.emplace(command, taskCommand).first->second;
+  }
+
+  static void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.clear();
+  }
+
+  // Number of file system look-ups done so far. For tests only, to verify
+  // that the cache works.
+  static int lookupCount() { return lookupCount_; }
+
+ private:
+  static std::string resolve(const std::string& command) {
+    namespace fs = std::filesystem;
+    ++lookupCount_;
+    return fs::is_symlink(command) ?
+        fs::path(fs::read_symlink(command)).filename() :
+        fs::path(command).filename();
+  }
+
+  static inline std::unordered_map<std::string, std::string> cache_;
+  static inline std::atomic<int> lookupCount_{0};
+  static inline std::mutex mutex_;
+};
+
 inline QString getTaskCommand(const QString& appCommand) {
-  return QString::fromStdString(getTaskCommand(appCommand.toStdString()));
+  return QString::fromStdString(
+      TaskCommandCache::get(getExecutablePath(appCommand).toStdString()));
+}
+
+inline std::string getTaskCommand(const std::string& appCommand) {
+  return getTaskCommand(QString::fromStdString(appCommand)).toStdString();
 }
 
 inline bool areTheSameCommand(const QString& appTaskCommand, const QString& taskCommand) {
@@ -0,0 +1,71 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "command_utils.h"
+
+#include <string>
+
+#include <QTest>
+
+namespace ksmoothdock {
+
+class CommandUtilsTest: public QObject {
+  Q_OBJECT
+
+ private slots:
+  void getExecutable();
+  void getExecutable_env();
+
+  // Tests that both overloads give the same task command.
+  void getTaskCommand_env();
+};
+
+void CommandUtilsTest::getExecutable() {
+  QCOMPARE(getExecutablePath("kate -b"), QString("kate"));
+  QCOMPARE(getExecutablePath("/usr/share/code/code --unity-launch"),
+           QString("/usr/share/code/code"));
+  QCOMPARE(ksmoothdock::getExecutable("/usr/share/code/code --unity-launch"),
+           QString("code"));
+  QCOMPARE(ksmoothdock::getExecutable(""), QString());
+}
+
+void CommandUtilsTest::getExecutable_env() {
+  QCOMPARE(getExecutablePath("env MOZ_ENABLE_WAYLAND=1 /usr/bin/firefox %u"),
+           QString("/usr/bin/firefox"));
+  QCOMPARE(ksmoothdock::getExecutable(
+               "/usr/bin/env A=1 B=2 steam -silent"),
+           QString("steam"));
+  QCOMPARE(ksmoothdock::getExecutable("env -i -u HOME PATH=/bin kate"),
+           QString("kate"));
+  QCOMPARE(ksmoothdock::getExecutable("env LANG=C"), QString());
+  // An executable named like an environment variable is not skipped without
+  // 'env'.
+  QCOMPARE(ksmoothdock::getExecutable("envsubst"), QString("envsubst"));
+}
+
+void CommandUtilsTest::getTaskCommand_env() {
+  QCOMPARE(getTaskCommand(QString("env FOO=1 app --x")), QString("app"));
+  QCOMPARE(getTaskCommand(std::string("env FOO=1 app --x")),
+           std::string("app"));
+  QCOMPARE(getTaskCommand(std::string("  app --x")), std::string("app"));
+}
+
+}  // namespace ksmoothdock
+
+QTEST_MAIN(ksmoothdock::CommandUtilsTest)
+#include "command_utils_test.moc"
@@ -20,6 +20,8 @@
 #define KSMOOTHDOCK_FONT_UTILS_H_
 
 #include <algorithm>
+#include <map>
+#include <tuple>
 #include <vector>
 
 #include <QFont>
@@ -30,10 +32,38 @@
 
 namespace ksmoothdock {
 
+// The cache of adjustFontSize()'s results, keyed by its arguments.
+using AdjustedFontCache =
+    std::map<std::tuple<int, int, QString, float, QString>, QFont>;
+
+inline AdjustedFontCache& adjustedFontCache() {
+  static AdjustedFontCache cache;
+  return cache;
+}
+
+// Clears the cache of adjustFontSize(). Must be called when the application
+// font or the appearance config has changed.
+inline void clearAdjustedFontCache() {
+  adjustedFontCache().clear();
+}
+
 // Returns a QFont with font size adjusted automatically according to the given
 // width, height, reference string and scale factor.
+//
+// This is called on every paint, so the results are cached.
 inline QFont adjustFontSize(int w, int h, const QString& referenceString,
                             float scaleFactor, const QString& fontFamily = "") {
+  // Every item size during zooming has an entry, so this is only a safeguard.
+  constexpr size_t kMaxCacheSize = 1024;
+
+  auto& cache = adjustedFontCache();
+  const auto key = std::make_tuple(w, h, referenceString, scaleFactor,
+                                   fontFamily);
+  const auto it = cache.find(key);
+  if (it != cache.end()) {
+    return it->second;
+  }
+
   QFont font;
   QFontMetrics metrics(font);
   const QRect& rect = metrics.tightBoundingRect(referenceString);
@@ -45,30 +75,40 @@ inline QFont adjustFontSize(int w, int h, const QString& referenceString,
     font.setFamily(fontFamily);
   }
 
+  if (cache.size() >= kMaxCacheSize) {
+    cache.clear();
+  }
+  cache.emplace(key, font);
   return font;
 }
 
 // Gets the list of base font families, i.e. just 'Noto Sans'
 // instead of 'Noto Sans Bold', 'Noto Sans CJK' etc.
-inline std::vector<QString> getBaseFontFamilies() {
-  std::vector<QString> baseFamilies;
-  QFontDatabase database;
-  const auto families = database.families(QFontDatabase::Latin);
-  for (int i = 0; i < families.size(); ++i) {
-    bool isBaseFont = true;
-    const auto family = families.at(i);
-    if (database.isSmoothlyScalable(family)) {
-      for (int j = 0; j < families.size(); ++j) {
-        if (family.startsWith(families[j] + ' ')) {
+// The list is computed once per process.
+inline const std::vector<QString>& getBaseFontFamilies() {
+  static const std::vector<QString> baseFamilies = [] {
+    std::vector<QString> baseFamilies;
+    QFontDatabase database;
+    auto families = database.families(QFontDatabase::Latin);
+    std::sort(families.begin(), families.end());
+    for (const auto& family : families) {
+      // Not a base font if a word prefix of it is also a font family, which
+      // is looked up in the sorted list.
+      bool isBaseFont = true;
+      for (int i = family.indexOf(' '); i >= 0;
+           i = family.indexOf(' ', i + 1)) {
+        if (std::binary_search(families.cbegin(), families.cend(),
+                               family.left(i))) {
           isBaseFont = false;
           break;
         }
       }
-      if (isBaseFont) {
+      if (isBaseFont && database.isSmoothlyScalable(family)) {
         baseFamilies.push_back(family);
       }
     }
-  }
+    return baseFamilies;
+  }();
   return baseFamilies;
 }
 
@@ -0,0 +1,33 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KSMOOTHDOCK_METRICS_H_
+#define KSMOOTHDOCK_METRICS_H_
+
+#include <QLoggingCategory>
+
+namespace ksmoothdock {
+
+// Logging category for performance metrics, e.g. start-up look-ups and
+// wake-ups. Disabled by default, enable it with:
+//   QT_LOGGING_RULES="ksmoothdock.metrics.info=true"
+Q_DECLARE_LOGGING_CATEGORY(lcMetrics)
+
+}  // namespace ksmoothdock
+
+#endif  // KSMOOTHDOCK_METRICS_H_
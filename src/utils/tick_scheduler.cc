@@ -0,0 +1,203 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tick_scheduler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include <QDateTime>
+#include <QDBusConnection>
+
+#include "metrics.h"
+
+namespace ksmoothdock {
+
+constexpr int TickScheduler::kClockChangeToleranceMs;
+
+TickScheduler::TickScheduler()
+    : nextId_(1),
+      screenLocked_(false),
+      scheduleMs_(0),
+      wakeups_(0) {
+  timer_.setSingleShot(true);
+  timer_.setTimerType(Qt::CoarseTimer);
+  connect(&timer_, SIGNAL(timeout()), this, SLOT(onTimeout()));
+  QDBusConnection::sessionBus().connect(
+      "org.freedesktop.ScreenSaver", "/ScreenSaver",
+      "org.freedesktop.ScreenSaver", "ActiveChanged",
+      this, SLOT(onScreenSaverActiveChanged(bool)));
+  QDBusConnection::systemBus().connect(
+      "org.freedesktop.login1", "/org/freedesktop/login1",
+      "org.freedesktop.login1.Manager", "PrepareForSleep",
+      this, SLOT(onPrepareForSleep(bool)));
+  wakeupsTimer_.start();
+}
+
+TickScheduler::~TickScheduler() {
+  if (wakeups_ > 0) {
+    qCInfo(lcMetrics) << "Tick scheduler wakeups:" << wakeupsPerSecond()
+                      << "/s";
+  }
+}
+
+int TickScheduler::subscribe(const QObject* owner, int intervalMs,
+                             std::function<void()> callback) {
+  const int id = nextId_++;
+  subscriptions_[id] = {owner, intervalMs, nextTick(intervalMs, now()),
+                        callback};
+  schedule();
+  return id;
+}
+
+void TickScheduler::unsubscribe(int id) {
+  subscriptions_.erase(id);
+  schedule();
+}
+
+void TickScheduler::pause(const QObject* owner) {
+  auto& ownerPause = pauses_[owner];
+  if (++ownerPause.count == 1) {
+    ownerPause.ownerDestroyed = connect(
+        owner, &QObject::destroyed, this,
+        [this, owner] { pauses_.erase(owner); });
+    schedule();
+  }
+}
+
+void TickScheduler::resume(const QObject* owner) {
+  const auto it = pauses_.find(owner);
+  if (it == pauses_.end()) {
+    return;
+  }
+
+  if (--it->second.count == 0) {
+    disconnect(it->second.ownerDestroyed);
+    pauses_.erase(it);
+    catchUp(owner);
+  }
+}
+
+double TickScheduler::wakeupsPerSecond() const {
+  return wakeups_ * 1000.0 / std::max<qint64>(wakeupsTimer_.elapsed(), 1);
+}
+
+void TickScheduler::onTimeout() {
+  ++wakeups_;
+  const qint64 nowMs = now();
+  if (std::abs(nowMs - scheduleMs_ - sinceSchedule_.elapsed()) >
+      kClockChangeToleranceMs) {
+    // The wall clock has been changed, e.g. set back, in which case the due
+    // times are too far ahead.
+    catchUp(nullptr);
+    return;
+  }
+
+  // Callbacks can unsubscribe, so the due ones are collected first.
+  std::vector<int> dueIds;
+  for (auto& subscription : subscriptions_) {
+    // Phase-locked ticks that coincide have the same due time.
+    if (isRunning(subscription.second) &&
+        subscription.second.dueMs <= nowMs) {
+      dueIds.push_back(subscription.first);
+      subscription.second.dueMs = nextTick(subscription.second.intervalMs,
+                                           nowMs);
+    }
+  }
+
+  for (const int id : dueIds) {
+    const auto it = subscriptions_.find(id);
+    if (it != subscriptions_.end()) {
+      it->second.callback();
+    }
+  }
+
+  // A coarse timer can fire a little early, in which case nothing was due
+  // and the timer is simply restarted for the remaining time.
+  schedule();
+}
+
+void TickScheduler::onScreenSaverActiveChanged(bool active) {
+  if (active == screenLocked_) {
+    return;
+  }
+
+  screenLocked_ = active;
+  if (screenLocked_) {
+    schedule();
+  } else {
+    // Catches up with the ticks missed while locked.
+    catchUp(nullptr);
+  }
+}
+
+void TickScheduler::onPrepareForSleep(bool sleeping) {
+  // The monotonic timer doesn't advance while the system is suspended, so the
+  // ticks would be late by the time spent suspended.
+  if (!sleeping) {
+    catchUp(nullptr);
+  }
+}
+
+qint64 TickScheduler::now() {
+  const QDateTime now = QDateTime::currentDateTime();
+  return now.toMSecsSinceEpoch() + now.offsetFromUtc() * 1000LL;
+}
+
+void TickScheduler::catchUp(const QObject* owner) {
+  const qint64 nowMs = now();
+  // Callbacks can unsubscribe, so the ones to call are collected first.
+  std::vector<int> ids;
+  for (auto& subscription : subscriptions_) {
+    if ((owner == nullptr || subscription.second.owner == owner) &&
+        isRunning(subscription.second)) {
+      ids.push_back(subscription.first);
+      subscription.second.dueMs = nextTick(subscription.second.intervalMs,
+                                           nowMs);
+    }
+  }
+
+  for (const int id : ids) {
+    const auto it = subscriptions_.find(id);
+    if (it != subscriptions_.end()) {
+      it->second.callback();
+    }
+  }
+  schedule();
+}
+
+void TickScheduler::schedule() {
+  qint64 dueMs = std::numeric_limits<qint64>::max();
+  for (const auto& subscription : subscriptions_) {
+    if (isRunning(subscription.second)) {
+      dueMs = std::min(dueMs, subscription.second.dueMs);
+    }
+  }
+  if (dueMs == std::numeric_limits<qint64>::max()) {
+    timer_.stop();
+    return;
+  }
+
+  scheduleMs_ = now();
+  sinceSchedule_.start();
+  timer_.start(static_cast<int>(std::max<qint64>(dueMs - scheduleMs_, 0)));
+}
+
+}  // namespace ksmoothdock
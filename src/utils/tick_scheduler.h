@@ -0,0 +1,138 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KSMOOTHDOCK_TICK_SCHEDULER_H_
+#define KSMOOTHDOCK_TICK_SCHEDULER_H_
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+namespace ksmoothdock {
+
+// Runs the periodic work of all docks' items (e.g. the clock and the
+// demanding-attention animation) from a single timer.
+//
+// Ticks are phase-locked to the wall clock, i.e. a subscription with an
+// interval of one minute runs on minute boundaries. Subscriptions whose ticks
+// coincide share one wakeup, whichever dock they belong to. The timer is
+// coarse, skips the subscriptions of paused owners (e.g. hidden docks) and
+// stops entirely while the screen is locked.
+//
+// The timer is monotonic, so the due times are recomputed when the wall clock
+// has been changed or the system has resumed from suspend.
+class TickScheduler : public QObject {
+  Q_OBJECT
+
+ public:
+  TickScheduler();
+  ~TickScheduler();
+
+  // Calls the callback every intervalMs while the owner (e.g. a dock) is not
+  // paused. Returns the subscription ID.
+  int subscribe(const QObject* owner, int intervalMs,
+                std::function<void()> callback);
+
+  void unsubscribe(int id);
+
+  // Pauses the owner's subscriptions. Pauses are reference-counted, so each
+  // call must be matched by a call to resume(), unless the owner is
+  // destroyed. When the owner is resumed, each of its callbacks is called
+  // once to catch up.
+  void pause(const QObject* owner);
+  void resume(const QObject* owner);
+
+  bool isPaused(const QObject* owner) const {
+    return pauses_.count(owner) > 0;
+  }
+
+  bool isScreenLocked() const { return screenLocked_; }
+
+  // For verifying the savings, across all docks.
+  int wakeups() const { return wakeups_; }
+  double wakeupsPerSecond() const;
+
+ private slots:
+  void onTimeout();
+  void onScreenSaverActiveChanged(bool active);
+  void onPrepareForSleep(bool sleeping);
+
+ private:
+  // The difference between the wall clock and the monotonic timer's elapsed
+  // times above which the wall clock is considered changed.
+  static constexpr int kClockChangeToleranceMs = 1000;
+
+  struct Pause {
+    int count;
+    // Forgets the pause when the owner is destroyed.
+    QMetaObject::Connection ownerDestroyed;
+  };
+
+  struct Subscription {
+    const QObject* owner;
+    int intervalMs;
+    // Wall clock time of the next tick.
+    qint64 dueMs;
+    std::function<void()> callback;
+  };
+
+  // Local wall clock time, in msecs.
+  static qint64 now();
+
+  static qint64 nextTick(int intervalMs, qint64 nowMs) {
+    return (nowMs / intervalMs + 1) * intervalMs;
+  }
+
+  bool isRunning(const Subscription& subscription) const {
+    return !screenLocked_ && !isPaused(subscription.owner);
+  }
+
+  // Calls the callbacks of the owner's running subscriptions once and
+  // recomputes their due times. All owners if owner is null.
+  void catchUp(const QObject* owner);
+
+  // Starts the timer for the earliest tick of the running subscriptions, or
+  // stops it.
+  void schedule();
+
+  std::map<int, Subscription> subscriptions_;
+  int nextId_;
+
+  // The pauses of the paused owners.
+  std::unordered_map<const QObject*, Pause> pauses_;
+
+  bool screenLocked_;
+
+  QTimer timer_;
+
+  // Wall clock time when the timer was last started, and the monotonic time
+  // since then, to detect changes to the wall clock.
+  qint64 scheduleMs_;
+  QElapsedTimer sinceSchedule_;
+
+  int wakeups_;
+  QElapsedTimer wakeupsTimer_;
+};
+
+}  // namespace ksmoothdock
+
+#endif  // KSMOOTHDOCK_TICK_SCHEDULER_H_
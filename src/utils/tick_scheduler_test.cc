@@ -0,0 +1,147 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tick_scheduler.h"
+
+#include <memory>
+#include <set>
+
+#include <QTest>
+
+namespace ksmoothdock {
+
+constexpr int kIntervalMs = 100;
+
+class TickSchedulerTest: public QObject {
+  Q_OBJECT
+
+ private slots:
+  // Tests that the callback is called periodically.
+  void subscribe();
+
+  // Tests that the callback is not called after unsubscribing.
+  void unsubscribe();
+
+  // Tests that a paused owner's callbacks are not called, and are called
+  // once to catch up when the owner is resumed as many times as paused.
+  void pause();
+
+  // Tests that the pause of a destroyed owner is forgotten.
+  void pause_ownerDestroyed();
+
+  // Tests that phase-locked ticks of different subscriptions share wakeups,
+  // including those of different owners.
+  void sharedWakeups();
+
+ private:
+  // The owners, e.g. docks.
+  QObject owner_;
+  QObject otherOwner_;
+};
+
+void TickSchedulerTest::subscribe() {
+  TickScheduler scheduler;
+  int ticks = 0;
+  scheduler.subscribe(&owner_, kIntervalMs, [&ticks] { ++ticks; });
+  QTRY_VERIFY(ticks >= 3);
+  QVERIFY(scheduler.wakeups() >= 3);
+  QVERIFY(scheduler.wakeupsPerSecond() > 0);
+}
+
+void TickSchedulerTest::unsubscribe() {
+  TickScheduler scheduler;
+  int ticks = 0;
+  const int id = scheduler.subscribe(&owner_, kIntervalMs,
+                                     [&ticks] { ++ticks; });
+  QTRY_VERIFY(ticks >= 1);
+
+  scheduler.unsubscribe(id);
+  const int wakeups = scheduler.wakeups();
+  ticks = 0;
+  QTest::qWait(3 * kIntervalMs);
+  QCOMPARE(ticks, 0);
+  QCOMPARE(scheduler.wakeups(), wakeups);
+}
+
+void TickSchedulerTest::pause() {
+  TickScheduler scheduler;
+  int ticks = 0;
+  int otherTicks = 0;
+  scheduler.subscribe(&owner_, kIntervalMs, [&ticks] { ++ticks; });
+  scheduler.subscribe(&otherOwner_, kIntervalMs,
+                      [&otherTicks] { ++otherTicks; });
+
+  scheduler.pause(&owner_);
+  scheduler.pause(&owner_);
+  QVERIFY(scheduler.isPaused(&owner_));
+  QVERIFY(!scheduler.isPaused(&otherOwner_));
+  QTRY_VERIFY(otherTicks >= 3);
+  QCOMPARE(ticks, 0);
+
+  scheduler.resume(&owner_);
+  QVERIFY(scheduler.isPaused(&owner_));
+  QCOMPARE(ticks, 0);
+
+  scheduler.resume(&owner_);
+  QVERIFY(!scheduler.isPaused(&owner_));
+  QCOMPARE(ticks, 1);
+  QTRY_VERIFY(ticks >= 2);
+
+  // Without any running subscriptions, the scheduler doesn't wake up.
+  scheduler.pause(&owner_);
+  scheduler.pause(&otherOwner_);
+  const int wakeups = scheduler.wakeups();
+  QTest::qWait(3 * kIntervalMs);
+  QCOMPARE(scheduler.wakeups(), wakeups);
+}
+
+void TickSchedulerTest::pause_ownerDestroyed() {
+  TickScheduler scheduler;
+  auto owner = std::make_unique<QObject>();
+  scheduler.pause(owner.get());
+  QVERIFY(scheduler.isPaused(owner.get()));
+
+  const QObject* destroyedOwner = owner.get();
+  owner.reset();
+  QVERIFY(!scheduler.isPaused(destroyedOwner));
+}
+
+void TickSchedulerTest::sharedWakeups() {
+  TickScheduler scheduler;
+  // The wakeups in which the callbacks have been called.
+  std::set<int> fastWakeups;
+  std::set<int> slowWakeups;
+  scheduler.subscribe(&owner_, kIntervalMs, [&scheduler, &fastWakeups] {
+    fastWakeups.insert(scheduler.wakeups());
+  });
+  scheduler.subscribe(&otherOwner_, 2 * kIntervalMs,
+                      [&scheduler, &slowWakeups] {
+    slowWakeups.insert(scheduler.wakeups());
+  });
+  QTRY_VERIFY(slowWakeups.size() >= 3);
+
+  // Every slow tick coincides with a fast tick.
+  for (const int wakeup : slowWakeups) {
+    QVERIFY(fastWakeups.count(wakeup) > 0);
+  }
+}
+
+}  // namespace ksmoothdock
+
+QTEST_MAIN(ksmoothdock::TickSchedulerTest)
+#include "tick_scheduler_test.moc"
@@ -18,7 +18,7 @@
 
 #include "wallpaper_helper.h"
 
-#include <QDBusMessage>
+#include <QDBusPendingCall>
 #include <QFile>
 #include <QGuiApplication>
 
@@ -27,11 +27,14 @@
 
 namespace ksmoothdock {
 
-WallpaperHelper::WallpaperHelper(MultiDockModel* model)
+constexpr char WallpaperHelper::kPlasmaShellService[];
+constexpr char WallpaperHelper::kPlasmaShellPath[];
+
+WallpaperHelper::WallpaperHelper(MultiDockModel* model, const QString& service,
+                                 const QString& path)
     : model_(model),
-      plasmaShellDBus_("org.kde.plasmashell",
-                       "/PlasmaShell",
-                       "org.kde.PlasmaShell") {}
+      plasmaShellDBus_(service, path, "org.kde.PlasmaShell"),
+      errorReported_(false) {}
 
 void WallpaperHelper::setPlasmaWallpapers() {
   if (!plasmaShellDBus_.isValid()) {  // Not running in KDE Plasma 5.
@@ -75,7 +78,23 @@ bool WallpaperHelper::doSetPlasmaWallpaper(int screen) {
     return false;
   }
 
-  const QDBusMessage response = plasmaShellDBus_.call(
+  auto& requests = requests_[screen];
+  if (requests.inFlight) {
+    // Supersedes any request already waiting.
+    requests.next = wallpaper;
+  } else if (wallpaper != requests.current) {
+    sendPlasmaWallpaper(screen, wallpaper);
+  }
+  return true;
+}
+
+void WallpaperHelper::sendPlasmaWallpaper(int screen,
+                                          const QString& wallpaper) {
+  auto& requests = requests_[screen];
+  requests.current = wallpaper;
+  requests.inFlight = true;
+
+  const QDBusPendingCall call = plasmaShellDBus_.asyncCall(
       "evaluateScript",
       "var allDesktops = desktops();"
       "d = allDesktops[" + QString::number(screen) + "];" +
@@ -83,15 +102,43 @@ bool WallpaperHelper::doSetPlasmaWallpaper(int screen) {
       "d.currentConfigGroup = Array('Wallpaper', 'org.kde.image','General');"
       "d.writeConfig('Image','file://"
       + wallpaper + "')");
-  if (response.type() == QDBusMessage::ErrorMessage) {
-    KMessageBox::error(
-        nullptr,
-        i18n("Failed to update wallpaper. Please make sure Plasma desktop "
-             "widgets are unlocked in order to set wallpaper."));
-    return false;
+  auto* watcher = new QDBusPendingCallWatcher(call, this);
+  connect(watcher, &QDBusPendingCallWatcher::finished, this,
+          [this, screen](QDBusPendingCallWatcher* watcher) {
+            onPlasmaWallpaperReply(screen, watcher);
+            watcher->deleteLater();
+          });
+}
+
+void WallpaperHelper::onPlasmaWallpaperReply(
+    int screen, QDBusPendingCallWatcher* watcher) {
+  auto& requests = requests_[screen];
+  requests.inFlight = false;
+  const QString next = requests.next;
+  requests.next.clear();
+
+  if (watcher->isError()) {
+    // Plasma's wallpaper is unknown, so it is set again next time. The
+    // waiting request is still sent, before the modal error message, so that
+    // the latest desktop switch is not lost.
+    requests.current.clear();
+    if (!next.isEmpty()) {
+      sendPlasmaWallpaper(screen, next);
+    }
+    if (!errorReported_) {
+      errorReported_ = true;
+      KMessageBox::error(
+          nullptr,
+          i18n("Failed to update wallpaper. Please make sure Plasma desktop "
+               "widgets are unlocked in order to set wallpaper."));
+    }
+    return;
   }
 
-  return true;
+  errorReported_ = false;
+  if (!next.isEmpty() && next != requests.current) {
+    sendPlasmaWallpaper(screen, next);
+  }
 }
 
 }  // namespace ksmoothdock
@@ -20,18 +20,32 @@
 #define KSMOOTHDOCK_WALLPAPER_HELPER_H_
 
 #include <QDBusInterface>
+#include <QDBusPendingCallWatcher>
+#include <QHash>
 #include <QObject>
+#include <QString>
 
 #include <model/multi_dock_model.h>
 
 namespace ksmoothdock {
 
 // Helper class for working with desktop wallpapers.
+//
+// Wallpapers are set on Plasma asynchronously. Per screen, at most one
+// request is in flight, unchanged wallpapers are skipped and a request
+// waiting for the in-flight one is superseded by any later one.
 class WallpaperHelper : public QObject {
   Q_OBJECT
 
  public:
-  explicit WallpaperHelper(MultiDockModel* model);
+  static constexpr char kPlasmaShellService[] = "org.kde.plasmashell";
+  static constexpr char kPlasmaShellPath[] = "/PlasmaShell";
+
+  // The Plasma shell D-Bus service and path can be replaced, e.g. by a
+  // stand-in service for testing.
+  explicit WallpaperHelper(MultiDockModel* model,
+                           const QString& service = kPlasmaShellService,
+                           const QString& path = kPlasmaShellPath);
   ~WallpaperHelper() = default;
 
  public slots:
@@ -42,11 +56,31 @@ class WallpaperHelper : public QObject {
   void setPlasmaWallpaper(int screen);
 
  private:
+  // The wallpaper requests to Plasma for a screen.
+  struct ScreenRequests {
+    // The wallpaper last sent to Plasma.
+    QString current;
+    // The wallpaper to send once the in-flight request has finished, if any.
+    QString next;
+    bool inFlight = false;
+  };
+
   bool doSetPlasmaWallpaper(int screen);
 
+  void sendPlasmaWallpaper(int screen, const QString& wallpaper);
+
+  void onPlasmaWallpaperReply(int screen, QDBusPendingCallWatcher* watcher);
+
   MultiDockModel* model_;
 
   QDBusInterface plasmaShellDBus_;
+
+  // By screen.
+  QHash<int, ScreenRequests> requests_;
+
+  // Whether a failed request has been reported since the last successful one,
+  // so that failures on several screens show only one error.
+  bool errorReported_;
 };
 
 }  // namespace ksmoothdock
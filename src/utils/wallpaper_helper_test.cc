@@ -0,0 +1,184 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "wallpaper_helper.h"
+
+#include <memory>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QThread>
+
+#include <KWindowSystem>
+
+namespace ksmoothdock {
+
+constexpr char kStandInConnection[] = "plasmashell_stand_in";
+constexpr int kScreen = 0;
+
+// A stand-in for the Plasma shell's D-Bus service that records the scripts.
+class PlasmaShellStandIn : public QObject {
+  Q_OBJECT
+  Q_CLASSINFO("D-Bus Interface", "org.kde.PlasmaShell")
+
+ public:
+  QStringList scripts() const {
+    QMutexLocker locker(&mutex_);
+    return scripts_;
+  }
+
+ public slots:
+  void evaluateScript(const QString& script) {
+    QMutexLocker locker(&mutex_);
+    scripts_.append(script);
+  }
+
+ private:
+  mutable QMutex mutex_;
+  QStringList scripts_;
+};
+
+class WallpaperHelperTest: public QObject {
+  Q_OBJECT
+
+ private slots:
+  void init() {
+    if (!QDBusConnection::sessionBus().isConnected()) {
+      QSKIP("No D-Bus session bus");
+    }
+
+    // The stand-in serves on its own connection and thread, so that the
+    // helper's blocking introspection on construction gets a reply.
+    service_ = QString("org.kde.ksmoothdock.test.PlasmaShell") +
+        QString::number(QCoreApplication::applicationPid());
+    plasmaShell_ = std::make_unique<PlasmaShellStandIn>();
+    plasmaShell_->moveToThread(&plasmaShellThread_);
+    plasmaShellThread_.start();
+    auto connection = QDBusConnection::connectToBus(
+        QDBusConnection::SessionBus, kStandInConnection);
+    QVERIFY(connection.registerService(service_));
+    QVERIFY(connection.registerObject(
+        WallpaperHelper::kPlasmaShellPath, plasmaShell_.get(),
+        QDBusConnection::ExportAllSlots));
+
+    QVERIFY(configDir_.isValid());
+    QVERIFY(cacheDir_.isValid());
+    model_ = std::make_unique<MultiDockModel>(configDir_.path(),
+                                              cacheDir_.path());
+    model_->addDock();
+    helper_ = std::make_unique<WallpaperHelper>(model_.get(), service_);
+  }
+
+  void cleanup() {
+    if (!plasmaShell_) {
+      return;
+    }
+
+    helper_.reset();
+    model_.reset();
+    auto connection = QDBusConnection(kStandInConnection);
+    connection.unregisterObject(WallpaperHelper::kPlasmaShellPath);
+    connection.unregisterService(service_);
+    QDBusConnection::disconnectFromBus(kStandInConnection);
+    plasmaShellThread_.quit();
+    plasmaShellThread_.wait();
+    plasmaShell_.reset();
+  }
+
+  // Tests that the wallpaper is sent to Plasma.
+  void setPlasmaWallpaper();
+
+  // Tests that an unchanged wallpaper is not sent again.
+  void setPlasmaWallpaper_unchanged();
+
+  // Tests that a request waiting for the in-flight one is superseded by a
+  // later one.
+  void setPlasmaWallpaper_superseded();
+
+ private:
+  // Creates a wallpaper file and sets it for the current desktop.
+  QString setWallpaper() {
+    auto file = std::make_unique<QTemporaryFile>();
+    file->open();
+    const QString wallpaper = file->fileName();
+    wallpaperFiles_.push_back(std::move(file));
+    model_->setWallpaper(KWindowSystem::currentDesktop(), kScreen, wallpaper);
+    return wallpaper;
+  }
+
+  QTemporaryDir configDir_;
+  QTemporaryDir cacheDir_;
+  QString service_;
+  std::unique_ptr<PlasmaShellStandIn> plasmaShell_;
+  QThread plasmaShellThread_;
+  std::unique_ptr<MultiDockModel> model_;
+  std::unique_ptr<WallpaperHelper> helper_;
+  std::vector<std::unique_ptr<QTemporaryFile>> wallpaperFiles_;
+};
+
+void WallpaperHelperTest::setPlasmaWallpaper() {
+  const QString wallpaper = setWallpaper();
+  helper_->setPlasmaWallpaper(kScreen);
+
+  QTRY_COMPARE(plasmaShell_->scripts().size(), 1);
+  QVERIFY(plasmaShell_->scripts()[0].contains("file://" + wallpaper));
+}
+
+void WallpaperHelperTest::setPlasmaWallpaper_unchanged() {
+  setWallpaper();
+  helper_->setPlasmaWallpaper(kScreen);
+  QTRY_COMPARE(plasmaShell_->scripts().size(), 1);
+
+  helper_->setPlasmaWallpaper(kScreen);
+  QTest::qWait(100);
+  QCOMPARE(plasmaShell_->scripts().size(), 1);
+
+  const QString wallpaper = setWallpaper();
+  helper_->setPlasmaWallpaper(kScreen);
+  QTRY_COMPARE(plasmaShell_->scripts().size(), 2);
+  QVERIFY(plasmaShell_->scripts()[1].contains("file://" + wallpaper));
+}
+
+void WallpaperHelperTest::setPlasmaWallpaper_superseded() {
+  // The first request is in flight until the event loop runs, so the second
+  // one waits and is superseded by the third one.
+  const QString first = setWallpaper();
+  helper_->setPlasmaWallpaper(kScreen);
+  setWallpaper();
+  helper_->setPlasmaWallpaper(kScreen);
+  const QString third = setWallpaper();
+  helper_->setPlasmaWallpaper(kScreen);
+
+  QTRY_COMPARE(plasmaShell_->scripts().size(), 2);
+  QTest::qWait(100);
+  QCOMPARE(plasmaShell_->scripts().size(), 2);
+  QVERIFY(plasmaShell_->scripts()[0].contains("file://" + first));
+  QVERIFY(plasmaShell_->scripts()[1].contains("file://" + third));
+}
+
+}  // namespace ksmoothdock
+
+QTEST_MAIN(ksmoothdock::WallpaperHelperTest)
+#include "wallpaper_helper_test.moc"
@@ -0,0 +1,192 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "wallpaper_thumbnail_cache.h"
+
+#include <iostream>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStringList>
+#include <QtConcurrent>
+
+namespace ksmoothdock {
+
+constexpr int WallpaperThumbnailCache::kMaxAgeDays;
+
+namespace {
+
+// Runs on a worker thread, so only uses QImage and not QPixmap.
+//
+// Args:
+//   keepFiles: the thumbnail files of the same wallpaper that are still in
+//              use. The wallpaper's other thumbnail files are outdated.
+QImage loadThumbnail(const QString& wallpaper, const QSize& size,
+                     const QString& cachePath, const QString& filePrefix,
+                     const QStringList& keepFiles) {
+  QImage thumbnail;
+  const QFileInfo cacheFile(cachePath);
+  QDir dir(cacheFile.absolutePath());
+  if (thumbnail.load(cachePath, "PNG") && thumbnail.size() == size) {
+    // Marks the file as recently used.
+    QFile file(cachePath);
+    if (file.open(QIODevice::ReadWrite)) {
+      file.setFileTime(QDateTime::currentDateTime(),
+                       QFileDevice::FileModificationTime);
+    }
+    return thumbnail;
+  }
+
+  // Wallpapers are often 4K or larger, so they are decoded directly at the
+  // thumbnail size (e.g. with JPEG's DCT scaling).
+  QImageReader reader(wallpaper);
+  reader.setScaledSize(size);
+  thumbnail = reader.read();
+  if (thumbnail.isNull()) {
+    std::cerr << "Could not load wallpaper " << wallpaper.toStdString()
+              << ": " << reader.errorString().toStdString() << std::endl;
+    return thumbnail;
+  }
+
+  QSaveFile file(cachePath);
+  if (QDir().mkpath(dir.absolutePath()) && file.open(QIODevice::WriteOnly) &&
+      thumbnail.save(&file, "PNG")) {
+    file.commit();
+  }
+
+  // Removes the wallpaper's outdated versions and unused sizes.
+  for (const auto& oldFile :
+       dir.entryList({filePrefix + "*.png"}, QDir::Files)) {
+    if (oldFile != cacheFile.fileName() && !keepFiles.contains(oldFile)) {
+      dir.remove(oldFile);
+    }
+  }
+  return thumbnail;
+}
+
+// Removes the thumbnails that haven't been used for the specified number of
+// days. Runs on a worker thread.
+void removeOldThumbnails(const QString& cacheDir, int maxAgeDays) {
+  const QDateTime oldest = QDateTime::currentDateTime().addDays(-maxAgeDays);
+  QDir dir(cacheDir);
+  for (const auto& fileInfo : dir.entryInfoList({"*.png"}, QDir::Files)) {
+    if (fileInfo.lastModified() < oldest) {
+      dir.remove(fileInfo.fileName());
+    }
+  }
+}
+
+}  // namespace
+
+WallpaperThumbnailCache::WallpaperThumbnailCache(const QString& cacheDir)
+    : cacheDir_(cacheDir) {
+  QtConcurrent::run(removeOldThumbnails, cacheDir_, kMaxAgeDays);
+}
+
+void WallpaperThumbnailCache::acquire(const QString& wallpaper,
+                                      const QSize& size) {
+  ++useCounts_[usageKey(wallpaper, size)];
+}
+
+void WallpaperThumbnailCache::release(const QString& wallpaper,
+                                      const QSize& size) {
+  const QString key = usageKey(wallpaper, size);
+  const auto it = useCounts_.find(key);
+  if (it != useCounts_.end() && --it.value() <= 0) {
+    useCounts_.erase(it);
+    thumbnails_.remove(key);
+  }
+}
+
+QPixmap WallpaperThumbnailCache::thumbnail(const QString& wallpaper,
+                                           const QSize& size) {
+  const QString key = usageKey(wallpaper, size);
+  const qint64 lastModified =
+      QFileInfo(wallpaper).lastModified().toMSecsSinceEpoch();
+  const auto it = thumbnails_.constFind(key);
+  if (it != thumbnails_.constEnd() && it->lastModified == lastModified) {
+    return it->pixmap;
+  }
+  const QString file = fileName(wallpaper, lastModified, size);
+  if (pending_.contains(file)) {
+    return QPixmap();
+  }
+
+  // The thumbnail files of the other sizes of the wallpaper in use.
+  QStringList keepFiles;
+  const QString wallpaperKey = usageKey(wallpaper, QSize());
+  for (auto count = useCounts_.constBegin(); count != useCounts_.constEnd();
+       ++count) {
+    if (count.key() != key && count.key().startsWith(wallpaperKey)) {
+      const QStringList dimensions =
+          count.key().mid(wallpaperKey.size()).split('x');
+      keepFiles.append(fileName(
+          wallpaper, lastModified,
+          QSize(dimensions.value(0).toInt(), dimensions.value(1).toInt())));
+    }
+  }
+
+  pending_.insert(file);
+  auto* watcher = new QFutureWatcher<QImage>(this);
+  connect(watcher, &QFutureWatcher<QImage>::finished, this,
+          [this, watcher, wallpaper, size, key, file, lastModified] {
+            pending_.remove(file);
+            watcher->deleteLater();
+            if (!useCounts_.contains(key)) {
+              return;  // No longer used.
+            }
+            thumbnails_[key] =
+                {lastModified, QPixmap::fromImage(watcher->result())};
+            emit thumbnailReady(wallpaper, size);
+          });
+  watcher->setFuture(QtConcurrent::run(
+      loadThumbnail, wallpaper, size, QDir(cacheDir_).filePath(file),
+      filePrefix(wallpaper), keepFiles));
+  return QPixmap();
+}
+
+QString WallpaperThumbnailCache::usageKey(const QString& wallpaper,
+                                          const QSize& size) {
+  // An invalid size gives the prefix of all sizes' keys.
+  return QFileInfo(wallpaper).absoluteFilePath() + '\n' + (size.isValid()
+      ? QString::number(size.width()) + 'x' + QString::number(size.height())
+      : QString());
+}
+
+QString WallpaperThumbnailCache::filePrefix(const QString& wallpaper) {
+  return QCryptographicHash::hash(
+      QFileInfo(wallpaper).absoluteFilePath().toUtf8(),
+      QCryptographicHash::Sha1).toHex() + '-';
+}
+
+QString WallpaperThumbnailCache::fileName(const QString& wallpaper,
+                                          qint64 lastModified,
+                                          const QSize& size) {
+  return filePrefix(wallpaper) + QString::number(lastModified) + '-' +
+      QString::number(size.width()) + 'x' + QString::number(size.height()) +
+      ".png";
+}
+
+}  // namespace ksmoothdock
@@ -0,0 +1,97 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KSMOOTHDOCK_WALLPAPER_THUMBNAIL_CACHE_H_
+#define KSMOOTHDOCK_WALLPAPER_THUMBNAIL_CACHE_H_
+
+#include <QHash>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QSize>
+#include <QString>
+
+namespace ksmoothdock {
+
+// Produces the pager's wallpaper thumbnails in the background.
+//
+// Thumbnails are kept in memory while they are used, so that all docks on
+// the same screen share them, and on disk keyed by wallpaper path,
+// modification time and size, so that full wallpapers are only decoded once.
+//
+// The disk cache only keeps the latest version of each wallpaper at the sizes
+// in use, and drops the thumbnails that haven't been used for kMaxAgeDays.
+class WallpaperThumbnailCache : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit WallpaperThumbnailCache(const QString& cacheDir);
+  ~WallpaperThumbnailCache() = default;
+
+  // Marks the thumbnail of the wallpaper at the specified size as used, e.g.
+  // by a desktop selector. Each call must be matched by a call to release().
+  void acquire(const QString& wallpaper, const QSize& size);
+
+  // Marks the thumbnail as no longer used. It is dropped from memory when
+  // it is no longer used at all.
+  void release(const QString& wallpaper, const QSize& size);
+
+  // Gets the thumbnail of the wallpaper at the specified size, which must be
+  // in use. If it is not ready yet, returns a null pixmap and emits
+  // thumbnailReady() once it has been produced.
+  QPixmap thumbnail(const QString& wallpaper, const QSize& size);
+
+ signals:
+  void thumbnailReady(const QString& wallpaper, const QSize& size);
+
+ private:
+  // Thumbnails on disk that haven't been used for this long are removed on
+  // start-up.
+  static constexpr int kMaxAgeDays = 30;
+
+  struct Thumbnail {
+    // The wallpaper's modification time when the thumbnail was produced.
+    qint64 lastModified;
+    // Null if the wallpaper could not be decoded.
+    QPixmap pixmap;
+  };
+
+  // The key of the wallpaper at the specified size, regardless of its
+  // version.
+  static QString usageKey(const QString& wallpaper, const QSize& size);
+
+  // The prefix of the wallpaper's thumbnail files on disk.
+  static QString filePrefix(const QString& wallpaper);
+
+  // The thumbnail file name of the wallpaper's version at the specified size.
+  static QString fileName(const QString& wallpaper, qint64 lastModified,
+                          const QSize& size);
+
+  const QString cacheDir_;
+
+  // Thumbnails by usage key.
+  QHash<QString, Thumbnail> thumbnails_;
+  // Use counts by usage key.
+  QHash<QString, int> useCounts_;
+  // File names of the thumbnails being produced.
+  QSet<QString> pending_;
+};
+
+}  // namespace ksmoothdock
+
+#endif  // KSMOOTHDOCK_WALLPAPER_THUMBNAIL_CACHE_H_
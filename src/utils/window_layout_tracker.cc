@@ -0,0 +1,188 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "window_layout_tracker.h"
+
+#include <KWindowInfo>
+
+namespace ksmoothdock {
+
+constexpr int WindowLayoutTracker::kIconSize;
+
+WindowLayoutTracker::WindowLayoutTracker()
+    : stackingOrder_(KWindowSystem::stackingOrder()) {
+  for (const auto wId : KWindowSystem::windows()) {
+    updateWindow(wId, true /* iconChanged */);
+  }
+
+  connect(KWindowSystem::self(), SIGNAL(windowAdded(WId)),
+          this, SLOT(onWindowAdded(WId)));
+  connect(KWindowSystem::self(), SIGNAL(windowRemoved(WId)),
+          this, SLOT(onWindowRemoved(WId)));
+  connect(KWindowSystem::self(),
+          SIGNAL(windowChanged(WId, NET::Properties, NET::Properties2)),
+          this,
+          SLOT(onWindowChanged(WId, NET::Properties, NET::Properties2)));
+  connect(KWindowSystem::self(), SIGNAL(stackingOrderChanged()),
+          this, SLOT(onStackingOrderChanged()));
+}
+
+std::vector<const WindowMiniature*> WindowLayoutTracker::windows(
+    int desktop) const {
+  std::vector<const WindowMiniature*> windows;
+  for (const auto wId : stackingOrder_) {
+    const auto it = windows_.find(wId);
+    if (it != windows_.end() && (it->second.desktop == desktop ||
+                                 it->second.desktop == NET::OnAllDesktops)) {
+      windows.push_back(&it->second);
+    }
+  }
+  return windows;
+}
+
+void WindowLayoutTracker::onWindowAdded(WId wId) {
+  updateWindow(wId, true /* iconChanged */);
+}
+
+void WindowLayoutTracker::onWindowRemoved(WId wId) {
+  const auto it = windows_.find(wId);
+  if (it != windows_.end()) {
+    const int desktop = it->second.desktop;
+    windows_.erase(it);
+    emit layoutChanged(desktop);
+  }
+}
+
+void WindowLayoutTracker::onWindowChanged(WId wId, NET::Properties properties,
+                                          NET::Properties2 properties2) {
+  // Title changes etc. are frequent and don't affect the layout.
+  if (!(properties & (NET::WMDesktop | NET::WMGeometry | NET::WMFrameExtents |
+                      NET::WMState | NET::XAWMState | NET::WMWindowType |
+                      NET::WMIcon))) {
+    return;
+  }
+
+  updateWindow(wId, properties & NET::WMIcon);
+}
+
+void WindowLayoutTracker::onStackingOrderChanged() {
+  const auto oldStacks = desktopStacks();
+  stackingOrder_ = KWindowSystem::stackingOrder();
+  const auto newStacks = desktopStacks();
+
+  // Usually only the desktops of the raised window are affected.
+  for (const auto& stack : newStacks) {
+    const auto it = oldStacks.find(stack.first);
+    if (it == oldStacks.end() || it->second != stack.second) {
+      emit layoutChanged(stack.first);
+    }
+  }
+  for (const auto& stack : oldStacks) {
+    if (newStacks.count(stack.first) == 0) {
+      emit layoutChanged(stack.first);
+    }
+  }
+}
+
+bool WindowLayoutTracker::readWindow(WId wId, WindowMiniature* window) {
+  KWindowInfo info(wId,
+                   NET::WMDesktop | NET::WMFrameExtents | NET::WMState |
+                       NET::XAWMState | NET::WMWindowType,
+                   NET::WM2WindowClass);
+  if (!info.valid()) {
+    return false;
+  }
+
+  const auto windowType = info.windowType(NET::DockMask | NET::DesktopMask);
+  if (windowType != NET::Normal && windowType != NET::Unknown) {
+    return false;
+  }
+
+  if ((info.state() & NET::SkipPager) || info.isMinimized()) {
+    return false;
+  }
+
+  // Filters out KSmoothDock dialogs.
+  if (QString(info.windowClassClass()).toLower() == "ksmoothdock") {
+    return false;
+  }
+
+  window->geometry = info.frameGeometry();
+  window->desktop = info.onAllDesktops() ? NET::OnAllDesktops : info.desktop();
+  return true;
+}
+
+void WindowLayoutTracker::updateWindow(WId wId, bool iconChanged) {
+  WindowMiniature window;
+  const bool shown = readWindow(wId, &window);
+  const auto it = windows_.find(wId);
+  if (it == windows_.end()) {
+    if (shown) {
+      window.icon = KWindowSystem::icon(wId, kIconSize, kIconSize,
+                                        true /* scale */);
+      windows_[wId] = window;
+      emit layoutChanged(window.desktop);
+    }
+    return;
+  }
+
+  const int oldDesktop = it->second.desktop;
+  if (!shown) {
+    windows_.erase(it);
+    emit layoutChanged(oldDesktop);
+    return;
+  }
+
+  if (window.geometry == it->second.geometry && window.desktop == oldDesktop &&
+      !iconChanged) {
+    return;
+  }
+
+  window.icon = iconChanged
+      ? KWindowSystem::icon(wId, kIconSize, kIconSize, true /* scale */)
+      : it->second.icon;
+  it->second = window;
+  emit layoutChanged(oldDesktop);
+  if (window.desktop != oldDesktop) {
+    emit layoutChanged(window.desktop);
+  }
+}
+
+std::unordered_map<int, std::vector<WId>>
+WindowLayoutTracker::desktopStacks() const {
+  // Windows on all desktops are part of every desktop's stack.
+  std::unordered_map<int, std::vector<WId>> stacks;
+  const int desktopCount = KWindowSystem::numberOfDesktops();
+  for (const auto wId : stackingOrder_) {
+    const auto it = windows_.find(wId);
+    if (it == windows_.end()) {
+      continue;
+    }
+
+    if (it->second.desktop == NET::OnAllDesktops) {
+      for (int desktop = 1; desktop <= desktopCount; ++desktop) {
+        stacks[desktop].push_back(wId);
+      }
+    } else {
+      stacks[it->second.desktop].push_back(wId);
+    }
+  }
+  return stacks;
+}
+
+}  // namespace ksmoothdock
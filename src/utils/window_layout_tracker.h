@@ -0,0 +1,89 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KSMOOTHDOCK_WINDOW_LAYOUT_TRACKER_H_
+#define KSMOOTHDOCK_WINDOW_LAYOUT_TRACKER_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include <QList>
+#include <QObject>
+#include <QPixmap>
+#include <QRect>
+
+#include <KWindowSystem>
+
+namespace ksmoothdock {
+
+// A window as shown in the pager.
+struct WindowMiniature {
+  // Frame geometry, in global coordinates.
+  QRect geometry;
+  // 1-based, or NET::OnAllDesktops.
+  int desktop;
+  QPixmap icon;
+};
+
+// Keeps track of the windows shown in the pager, incrementally from window
+// events.
+class WindowLayoutTracker : public QObject {
+  Q_OBJECT
+
+ public:
+  static constexpr int kIconSize = 16;
+
+  WindowLayoutTracker();
+  ~WindowLayoutTracker() = default;
+
+  // Gets the windows shown on the desktop, in stacking order from bottom to
+  // top.
+  std::vector<const WindowMiniature*> windows(int desktop) const;
+
+ signals:
+  // The windows shown on the desktop have changed. The desktop is
+  // NET::OnAllDesktops if all desktops are affected.
+  void layoutChanged(int desktop);
+
+ private slots:
+  void onWindowAdded(WId wId);
+  void onWindowRemoved(WId wId);
+  void onWindowChanged(WId wId, NET::Properties properties,
+                       NET::Properties2 properties2);
+  void onStackingOrderChanged();
+
+ private:
+  // Reads the window's miniature, except the icon. Returns false if the
+  // window is not shown in the pager.
+  static bool readWindow(WId wId, WindowMiniature* window);
+
+  // Re-reads the window and emits layoutChanged() for the desktops that it
+  // was and is on, if it has changed.
+  void updateWindow(WId wId, bool iconChanged);
+
+  // Gets the stacking order of the shown windows by desktop.
+  std::unordered_map<int, std::vector<WId>> desktopStacks() const;
+
+  std::unordered_map<WId, WindowMiniature> windows_;
+  // From bottom to top.
+  QList<WId> stackingOrder_;
+};
+
+}  // namespace ksmoothdock
+
+#endif  // KSMOOTHDOCK_WINDOW_LAYOUT_TRACKER_H_
@@ -54,7 +54,8 @@ class AddPanelDialogTest: public QObject {
  private:
   void init(AddPanelDialog::Mode mode) {
     QTemporaryDir configDir;
-    model_ = std::make_unique<MultiDockModel>(configDir.path());
+    model_ = std::make_unique<MultiDockModel>(configDir.path(),
+                                              cacheDir_.path());
     if (mode != AddPanelDialog::Mode::Welcome) {
       model_->addDock();
     }
@@ -63,6 +64,7 @@ class AddPanelDialogTest: public QObject {
     dialog_->setMode(mode);
   }
 
+  QTemporaryDir cacheDir_;
   std::unique_ptr<MultiDockModel> model_;
   std::unique_ptr<AddPanelDialog> dialog_;
 };
@@ -35,7 +35,8 @@ class AppearanceSettingsDialogTest: public QObject {
  private slots:
   void init() {
     QTemporaryDir configDir;
-    model_ = std::make_unique<MultiDockModel>(configDir.path());
+    model_ = std::make_unique<MultiDockModel>(configDir.path(),
+                                              cacheDir_.path());
     model_->setMinIconSize(48);
     model_->setMaxIconSize(128);
     model_->setSpacingFactor(0.5);
@@ -67,6 +68,7 @@ class AppearanceSettingsDialogTest: public QObject {
     return std::abs(x - y) < kDelta;
   }
 
+  QTemporaryDir cacheDir_;
   std::unique_ptr<MultiDockModel> model_;
   std::unique_ptr<AppearanceSettingsDialog> dialog_;
 };
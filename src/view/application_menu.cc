@@ -22,8 +22,11 @@
 
 #include <QApplication>
 #include <QDrag>
+#include <QFontMetrics>
+#include <QIconEngine>
 #include <QMimeData>
-#include <QStringBuilder>
+#include <QPainter>
+#include <QStyleOptionMenuItem>
 #include <QUrl>
 
 #include <KDesktopFile>
@@ -34,71 +37,317 @@
 #include "dock_panel.h"
 #include "program.h"
 #include <utils/draw_utils.h>
+#include <utils/metrics.h>
 
 namespace ksmoothdock {
 
+namespace {
+
+// Icon engine that defers loading the icon until it is first painted.
+class LazyIconEngine : public QIconEngine {
+ public:
+  explicit LazyIconEngine(const QString& name)
+      : name_(name), loaded_(false), existsChecked_(false), exists_(false) {}
+
+  void paint(QPainter* painter, const QRect& rect, QIcon::Mode mode,
+             QIcon::State state) override {
+    painter->drawPixmap(rect, pixmap(rect.size(), mode, state));
+  }
+
+  QPixmap pixmap(const QSize& size, QIcon::Mode mode,
+                 QIcon::State state) override {
+    return icon().pixmap(size, mode, state);
+  }
+
+  QList<QSize> availableSizes(QIcon::Mode mode, QIcon::State state)
+      const override {
+    if (!exists()) {
+      return {};
+    }
+    return {QSize(kApplicationMenuIconSize, kApplicationMenuIconSize)};
+  }
+
+  QIconEngine* clone() const override { return new LazyIconEngine(*this); }
+
+  void virtual_hook(int id, void* data) override {
+    // The icon is null if it can't be found, so that the menu leaves out
+    // the icon instead of drawing the 'unknown' icon.
+    if (id == QIconEngine::IsNullHook) {
+      *reinterpret_cast<bool*>(data) = !exists();
+      return;
+    }
+    QIconEngine::virtual_hook(id, data);
+  }
+
+ private:
+  // Looks up the icon's path without loading it. This is done on first use.
+  bool exists() const {
+    if (!existsChecked_) {
+      exists_ = !name_.isEmpty() &&
+          !KIconLoader::global()->iconPath(
+              name_, KIconLoader::Small, /*canReturnNull=*/true).isEmpty();
+      existsChecked_ = true;
+    }
+    return exists_;
+  }
+
+  const QIcon& icon() {
+    if (!loaded_) {
+      icon_ = QIcon(KIconLoader::global()->loadIcon(
+          name_, KIconLoader::NoGroup, kApplicationMenuIconSize));
+      loaded_ = true;
+    }
+    return icon_;
+  }
+
+  QString name_;
+  bool loaded_;
+  QIcon icon_;
+  mutable bool existsChecked_;
+  mutable bool exists_;
+};
+
+}  // namespace
+
+constexpr int ApplicationMenuStyle::kBorderRadius;
+constexpr int ApplicationMenuStyle::kItemHPadding;
+constexpr int ApplicationMenuStyle::kItemVPadding;
+constexpr int ApplicationMenuStyle::kSeparatorMargin;
+
 int ApplicationMenuStyle::pixelMetric(
     PixelMetric metric, const QStyleOption *option, const QWidget *widget)
     const {
-  if (metric == QStyle::PM_SmallIconSize) {
-    return kApplicationMenuIconSize;
+  switch (metric) {
+    case QStyle::PM_SmallIconSize:
+      return kApplicationMenuIconSize;
+    case QStyle::PM_MenuPanelWidth:
+      return 1;
+    case QStyle::PM_MenuHMargin:  // fall through
+    case QStyle::PM_MenuVMargin:
+      return 2;
+    default:
+      return QProxyStyle::pixelMetric(metric, option, widget);
   }
-  return QProxyStyle::pixelMetric(metric, option, widget);
 }
 
-ApplicationMenu::ApplicationMenu(
-    DockPanel *parent, MultiDockModel* model, Qt::Orientation orientation,
-    int minSize, int maxSize)
-    : IconBasedDockItem(parent, "" /* label */, orientation, "" /* iconName */,
-                        minSize, maxSize),
-      model_(model),
-      showingMenu_(false) {
-  menu_.setStyle(&style_);
-  menu_.setStyleSheet(getStyleSheet());
+void ApplicationMenuStyle::drawPrimitive(
+    PrimitiveElement element, const QStyleOption* option, QPainter* painter,
+    const QWidget* widget) const {
+  if (element == QStyle::PE_PanelMenu) {
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(backgroundColor_);
+    painter->drawRoundedRect(option->rect, kBorderRadius, kBorderRadius);
+    painter->restore();
+  } else if (element != QStyle::PE_FrameMenu) {
+    QProxyStyle::drawPrimitive(element, option, painter, widget);
+  }
+}
 
-  loadConfig();
-  buildMenu();
+void ApplicationMenuStyle::drawControl(
+    ControlElement element, const QStyleOption* option, QPainter* painter,
+    const QWidget* widget) const {
+  const auto* menuItem = qstyleoption_cast<const QStyleOptionMenuItem*>(option);
+  if (element != QStyle::CE_MenuItem || menuItem == nullptr) {
+    QProxyStyle::drawControl(element, option, painter, widget);
+    return;
+  }
+
+  const QRect& rect = menuItem->rect;
+  painter->save();
+  if (menuItem->menuItemType == QStyleOptionMenuItem::Separator) {
+    const int y = rect.center().y();
+    painter->setPen(borderColor_);
+    painter->drawLine(rect.left() + kSeparatorMargin, y,
+                      rect.right() - kSeparatorMargin, y);
+    painter->restore();
+    return;
+  }
 
-  createContextMenu();
+  if (menuItem->state & QStyle::State_Selected) {
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(borderColor_);
+    painter->setBrush(backgroundColor_);
+    painter->drawRoundedRect(QRectF(rect).adjusted(0.5, 0.5, -0.5, -0.5),
+                             kBorderRadius, kBorderRadius);
+  }
+
+  if (!menuItem->icon.isNull()) {
+    const int iconSize = kApplicationMenuIconSize;
+    const QRect iconRect(rect.left() + (kItemHPadding - iconSize) / 2,
+                         rect.top() + (rect.height() - iconSize) / 2,
+                         iconSize, iconSize);
+    menuItem->icon.paint(painter, iconRect);
+  }
+
+  QFont font = menuItem->font;
+  font.setBold(true);
+  painter->setFont(font);
+  painter->setPen(Qt::white);
+  QString text = menuItem->text;
+  text = text.left(text.indexOf('\t'));  // Strips the shortcut, if any.
+  painter->drawText(
+      rect.adjusted(kItemHPadding, 0, -kItemHPadding, 0),
+      Qt::AlignLeft | Qt::AlignVCenter | Qt::TextShowMnemonic, text);
+
+  if (menuItem->menuItemType == QStyleOptionMenuItem::SubMenu) {
+    const int arrowSize = rect.height() / 3;
+    QStyleOptionMenuItem arrowOption = *menuItem;
+    arrowOption.rect = QRect(
+        rect.right() - (kItemHPadding + arrowSize) / 2,
+        rect.top() + (rect.height() - arrowSize) / 2, arrowSize, arrowSize);
+    arrowOption.palette.setColor(QPalette::ButtonText, Qt::white);
+    arrowOption.palette.setColor(QPalette::WindowText, Qt::white);
+    proxy()->drawPrimitive(QStyle::PE_IndicatorArrowRight, &arrowOption,
+                           painter, widget);
+  }
+  painter->restore();
+}
+
+QSize ApplicationMenuStyle::sizeFromContents(
+    ContentsType type, const QStyleOption* option, const QSize& size,
+    const QWidget* widget) const {
+  const auto* menuItem = qstyleoption_cast<const QStyleOptionMenuItem*>(option);
+  if (type != QStyle::CT_MenuItem || menuItem == nullptr) {
+    return QProxyStyle::sizeFromContents(type, option, size, widget);
+  }
+
+  if (menuItem->menuItemType == QStyleOptionMenuItem::Separator) {
+    return QSize(size.width(), 2 * kSeparatorMargin + 1);
+  }
+
+  QFont font = menuItem->font;
+  font.setBold(true);
+  const QFontMetrics metrics(font);
+  QString text = menuItem->text;
+  text = text.left(text.indexOf('\t'));
+  return QSize(
+      2 * kItemHPadding + metrics.horizontalAdvance(text),
+      std::max(kApplicationMenuIconSize, metrics.height()) +
+          2 * kItemVPadding);
+}
+
+ApplicationMenuPopup::ApplicationMenuPopup(MultiDockModel* model)
+    : model_(model),
+      searchPopup_(model),
+      owner_(nullptr),
+      warmedUp_(false),
+      popupLatencyMs_(-1) {
+  setUpMenu(&menu_);
+  menu_.installEventFilter(this);
+  updateStyle();
+  buildMenu();
 
-  connect(&menu_, SIGNAL(aboutToShow()), parent_,
-          SLOT(setStrutForApplicationMenu()));
   connect(&menu_, &QMenu::aboutToShow, this,
-          [this]() { showingMenu_ = true; } );
-  connect(&menu_, SIGNAL(aboutToHide()), parent_, SLOT(setStrut()));
+          [this]() { if (owner_) { owner_->onMenuAboutToShow(); } });
   connect(&menu_, &QMenu::aboutToHide, this,
-          [this]() { showingMenu_ = false; } );
+          [this]() { if (owner_) { owner_->onMenuAboutToHide(); } });
   connect(model_, SIGNAL(applicationMenuConfigChanged()),
           this, SLOT(reloadMenu()));
+  connect(model_, &MultiDockModel::applicationMenuEntriesChanged,
+          this, &ApplicationMenuPopup::onApplicationMenuEntriesChanged);
+  connect(model_, SIGNAL(appearanceChanged()), this, SLOT(updateStyle()));
 }
 
-void ApplicationMenu::draw(QPainter* painter) const {
-  if (showingMenu_) {
-    drawHighlightedIcon(model_->backgroundColor(), left_, top_, getWidth(), getHeight(),
-                        minSize_ / 4 - 4, size_ / 8, painter);
+void ApplicationMenuPopup::popup(ApplicationMenu* owner) {
+  if (owner_ && owner_ != owner && menu_.isVisible()) {
+    menu_.hide();
   }
-  IconBasedDockItem::draw(painter);
+  owner_ = owner;
+  popupTimer_.start();
+  menu_.popup(owner_->dock()->applicationMenuPosition(getMenuSize()));
 }
 
-void ApplicationMenu::mousePressEvent(QMouseEvent *e) {
-  if (e->button() == Qt::LeftButton) {
-    menu_.popup(parent_->applicationMenuPosition(getMenuSize()));
-  } else if (e->button() == Qt::RightButton) {
-    contextMenu_.popup(e->globalPos());
+void ApplicationMenuPopup::release(ApplicationMenu* owner) {
+  if (owner_ == owner) {
+    owner_ = nullptr;
+    menu_.hide();
   }
 }
 
-void ApplicationMenu::reloadMenu() {
+void ApplicationMenuPopup::warmUp() {
+  if (warmedUp_) {
+    return;
+  }
+  warmedUp_ = true;
+
+  menu_.ensurePolished();
+  menu_.winId();  // Creates the native window.
+  getMenuSize();  // Lays out the menu.
+  loadIcons(&menu_);
+
+  for (const auto& category : model_->applicationMenuCategories()) {
+    QMenu* menu = categoryMenus_.value(category.name);
+    if (menu) {
+      populateMenu(category, menu);
+      menu->ensurePolished();
+      menu->winId();
+      menu->sizeHint();
+      loadIcons(menu);
+      break;
+    }
+  }
+}
+
+void ApplicationMenuPopup::reloadMenu() {
   menu_.clear();
+  categoryMenus_.clear();
   buildMenu();
+  warmedUp_ = false;
 }
 
-bool ApplicationMenu::eventFilter(QObject* object, QEvent* event) {
+void ApplicationMenuPopup::onApplicationMenuEntriesChanged(
+    const ApplicationMenuDelta& delta) {
+  for (const auto& category : model_->applicationMenuCategories()) {
+    if (!delta.changedCategories.contains(category.name)) {
+      continue;
+    }
+
+    QMenu* menu = categoryMenus_.value(category.name);
+    if ((menu == nullptr) != category.entries.empty()) {
+      // The category's sub-menu needs to be added or removed.
+      reloadMenu();
+      return;
+    }
+
+    if (menu) {
+      // Re-populated on its next show, unless it is being shown.
+      menu->clear();
+      if (menu->isVisible()) {
+        populateMenu(category, menu);
+      }
+      warmedUp_ = false;
+    }
+  }
+}
+
+void ApplicationMenuPopup::updateStyle() {
+  style_.setColors(model_->backgroundColor(), model_->borderColor());
+  menu_.update();
+}
+
+bool ApplicationMenuPopup::eventFilter(QObject* object, QEvent* event) {
+  if (object == &menu_) {
+    if (event->type() == QEvent::Paint && popupTimer_.isValid()) {
+      const bool firstPopup = popupLatencyMs_ < 0;
+      popupLatencyMs_ = static_cast<int>(popupTimer_.elapsed());
+      popupTimer_.invalidate();
+      if (firstPopup) {
+        qCInfo(lcMetrics) << "Application menu first popup latency:"
+                          << popupLatencyMs_ << "ms";
+      }
+    }
+    return QObject::eventFilter(object, event);
+  }
+
   QMenu* menu = dynamic_cast<QMenu*>(object);
   if (menu) {
     if (event->type() == QEvent::Show) {
-      menu->popup(parent_->applicationSubMenuPosition(getMenuSize(),
-                                                         menu->geometry()));
+      if (owner_) {
+        menu->popup(owner_->dock()->applicationSubMenuPosition(
+            getMenuSize(), menu->geometry()));
+      }
       // Filter this event.
       return true;
     } else if (event->type() == QEvent::MouseButtonPress) {
@@ -131,66 +380,43 @@ bool ApplicationMenu::eventFilter(QObject* object, QEvent* event) {
   return QObject::eventFilter(object, event);
 }
 
-QString ApplicationMenu::getStyleSheet() {
-  QColor bgColor = model_->backgroundColor();
-  QColor borderColor = model_->borderColor();
-  return " \
-QMenu { \
-  background-color: " % bgColor.name(QColor::HexArgb) % ";"
-" margin: 1px; \
-  padding: 2px; \
-  border: 1px transparent; \
-  border-radius: 3px; \
-} \
-\
-QMenu::item { \
-  font: bold; \
-  color: white; \
-  background-color: transparent; \
-  padding: 4px 45px 4px 45px; \
-} \
-\
-QMenu::item:selected { \
-  background-color: " % bgColor.name(QColor::HexArgb) % ";"
-" border: 1px solid " % borderColor.name() % ";"
-" border-radius: 3px; \
-} \
-\
-QMenu::separator { \
-  margin: 5px; \
-  height: 1px; \
-  background: " % borderColor.name() % ";"
-"}";
-}
-
-void ApplicationMenu::loadConfig() {
-  setLabel(model_->applicationMenuName());
-  setIconName(model_->applicationMenuIcon());
-}
-
-void ApplicationMenu::buildMenu() {
+void ApplicationMenuPopup::buildMenu() {
   addToMenu(model_->applicationMenuCategories());
   menu_.addSeparator();
   addToMenu(ApplicationMenuConfig::kSessionSystemCategories);
-  addEntry(ApplicationMenuConfig::kSearchEntry, &menu_);
+  const auto& searchEntry = ApplicationMenuConfig::kSearchEntry;
+  menu_.addAction(loadIcon(searchEntry.icon), searchEntry.name, this,
+                  [this]() { showSearchPopup(); });
 }
 
-void ApplicationMenu::addToMenu(const std::vector<Category>& categories) {
+void ApplicationMenuPopup::addToMenu(const std::vector<Category>& categories) {
   for (const auto& category : categories) {
     if (category.entries.empty()) {
       continue;
     }
 
     QMenu* menu = menu_.addMenu(loadIcon(category.icon), category.displayName);
-    menu->setStyle(&style_);
-    for (const auto& entry : category.entries) {
-      addEntry(entry, menu);
-    }
+    setUpMenu(menu);
+    categoryMenus_[category.name] = menu;
+    connect(menu, &QMenu::aboutToShow, this,
+            [this, &category, menu]() { populateMenu(category, menu); });
     menu->installEventFilter(this);
   }
 }
 
-void ApplicationMenu::addEntry(const ApplicationEntry &entry, QMenu *menu) {
+void ApplicationMenuPopup::populateMenu(const Category& category,
+                                        QMenu* menu) {
+  if (!menu->isEmpty()) {
+    return;
+  }
+
+  for (const auto* entry : category.entries) {
+    addEntry(*entry, menu);
+  }
+}
+
+void ApplicationMenuPopup::addEntry(const ApplicationEntry &entry,
+                                    QMenu *menu) {
   QAction* action = menu->addAction(loadIcon(entry.icon), entry.name, this,
                   [&entry]() {
                     Program::launch(entry.command);
@@ -198,18 +424,89 @@ void ApplicationMenu::addEntry(const ApplicationEntry &entry, QMenu *menu) {
   action->setData(entry.desktopFile);
 }
 
-QIcon ApplicationMenu::loadIcon(const QString &icon) {
-  return QIcon(KIconLoader::global()->loadIcon(
-      icon, KIconLoader::NoGroup, kApplicationMenuIconSize));
+void ApplicationMenuPopup::setUpMenu(QMenu* menu) {
+  menu->setStyle(&style_);
+  // The background is drawn by the style with the dock's translucent color.
+  menu->setAttribute(Qt::WA_TranslucentBackground);
+}
+
+void ApplicationMenuPopup::showSearchPopup() {
+  if (owner_) {
+    searchPopup_.popup(owner_->dock()->applicationMenuPosition(
+        searchPopup_.size()));
+  }
+}
+
+void ApplicationMenuPopup::loadIcons(QMenu* menu) {
+  for (const auto* action : menu->actions()) {
+    const QIcon icon = action->icon();
+    if (!icon.isNull()) {
+      icon.pixmap(kApplicationMenuIconSize);
+    }
+  }
+}
+
+QIcon ApplicationMenuPopup::loadIcon(const QString &icon) {
+  return QIcon(new LazyIconEngine(icon));
+}
+
+ApplicationMenu::ApplicationMenu(
+    DockPanel *parent, MultiDockModel* model, ApplicationMenuPopup* popup,
+    Qt::Orientation orientation, int minSize, int maxSize)
+    : IconBasedDockItem(parent, "" /* label */, orientation, "" /* iconName */,
+                        minSize, maxSize),
+      model_(model),
+      popup_(popup),
+      showingMenu_(false) {
+  loadConfig();
+}
+
+ApplicationMenu::~ApplicationMenu() {
+  popup_->release(this);
+}
+
+void ApplicationMenu::draw(QPainter* painter) const {
+  if (showingMenu_) {
+    drawHighlightedIcon(model_->backgroundColor(), left_, top_, getWidth(), getHeight(),
+                        minSize_ / 4 - 4, size_ / 8, painter);
+  }
+  IconBasedDockItem::draw(painter);
+}
+
+void ApplicationMenu::mousePressEvent(QMouseEvent *e) {
+  if (e->button() == Qt::LeftButton) {
+    popup_->popup(this);
+  } else if (e->button() == Qt::RightButton) {
+    if (!contextMenu_) {
+      createContextMenu();
+    }
+    contextMenu_->popup(e->globalPos());
+  }
+}
+
+void ApplicationMenu::loadConfig() {
+  setLabel(model_->applicationMenuName());
+  setIconName(model_->applicationMenuIcon());
+}
+
+void ApplicationMenu::onMenuAboutToShow() {
+  showingMenu_ = true;
+  parent_->setStrutForApplicationMenu();
+}
+
+void ApplicationMenu::onMenuAboutToHide() {
+  showingMenu_ = false;
+  parent_->setStrut();
 }
 
 void ApplicationMenu::createContextMenu() {
-  contextMenu_.addAction(QIcon::fromTheme("configure"),
+  contextMenu_ = std::make_unique<QMenu>();
+  contextMenu_->addAction(QIcon::fromTheme("configure"),
                          i18n("Application Menu &Settings"),
                          parent_,
                          [this] { parent_->showApplicationMenuSettingsDialog(); });
-  contextMenu_.addSeparator();
-  parent_->addPanelSettings(&contextMenu_);
+  contextMenu_->addSeparator();
+  parent_->addPanelSettings(contextMenu_.get());
 }
 
 }  // namespace ksmoothdock
@@ -19,9 +19,15 @@
 #ifndef KSMOOTHDOCK_APPLICATION_MENU_H_
 #define KSMOOTHDOCK_APPLICATION_MENU_H_
 
+#include "application_search_popup.h"
 #include "icon_based_dock_item.h"
 
+#include <memory>
+
+#include <QColor>
+#include <QElapsedTimer>
 #include <QEvent>
+#include <QHash>
 #include <QMenu>
 #include <QMouseEvent>
 #include <QPoint>
@@ -36,78 +42,184 @@ namespace ksmoothdock {
 
 constexpr int kApplicationMenuIconSize = 32;
 
+// The style of the application menu. Draws the same translucent background,
+// selection and separators as the dock's, from cached colors, so the menus
+// don't need style sheets.
 class ApplicationMenuStyle : public QProxyStyle {
  public:
+  void setColors(const QColor& backgroundColor, const QColor& borderColor) {
+    backgroundColor_ = backgroundColor;
+    borderColor_ = borderColor;
+  }
+
   int pixelMetric(PixelMetric metric, const QStyleOption *option = Q_NULLPTR,
                   const QWidget *widget = Q_NULLPTR) const override;
+
+  void drawPrimitive(PrimitiveElement element, const QStyleOption* option,
+                     QPainter* painter,
+                     const QWidget* widget = Q_NULLPTR) const override;
+
+  void drawControl(ControlElement element, const QStyleOption* option,
+                   QPainter* painter,
+                   const QWidget* widget = Q_NULLPTR) const override;
+
+  QSize sizeFromContents(ContentsType type, const QStyleOption* option,
+                         const QSize& size,
+                         const QWidget* widget = Q_NULLPTR) const override;
+
+ private:
+  static constexpr int kBorderRadius = 3;
+  // Horizontal and vertical padding of the menu items.
+  static constexpr int kItemHPadding = 45;
+  static constexpr int kItemVPadding = 4;
+  // Margin around the separators.
+  static constexpr int kSeparatorMargin = 5;
+
+  QColor backgroundColor_;
+  QColor borderColor_;
 };
 
 
-// The application menu item on the dock.
+class ApplicationMenu;
+
+// The cascading popup menu that contains entries for all applications
+// organized by categories. The menu uses a custom style e.g. bigger icon size
+// and the same translucent effect as the dock's.
 //
-// Left-clicking the item shows a cascading popup menu that contains entries
-// for all applications organized by categories. The menu uses a custom style
-// e.g. bigger icon size and the same translucent effect as the dock's.
+// The popup menu is shared by the application menu items of all docks, which
+// only provide its placement.
+//
+// The category sub-menus are populated on their first show, and the icons are
+// only loaded when they are first painted, so building the menu is cheap.
 //
 // Supports drag-and-drop as a drag source.
 // What it means is that you can drag an application entry from the menu
 // to other widgets/applications. It doesn't support drag-and-drop within the
 // menu itself.
-class ApplicationMenu : public QObject, public IconBasedDockItem {
+class ApplicationMenuPopup : public QObject {
   Q_OBJECT
 
  public:
-  ApplicationMenu(
-      DockPanel* parent,
-      MultiDockModel* model,
-      Qt::Orientation orientation,
-      int minSize,
-      int maxSize);
-  virtual ~ApplicationMenu() = default;
-
-  void draw(QPainter* painter) const override;
-  void mousePressEvent(QMouseEvent* e) override;
-  void loadConfig() override;
+  explicit ApplicationMenuPopup(MultiDockModel* model);
+  virtual ~ApplicationMenuPopup() = default;
 
   QSize getMenuSize() { return menu_.sizeHint(); }
 
-public slots:
- void reloadMenu();
+  // Shows the menu for the given application menu item.
+  void popup(ApplicationMenu* owner);
+
+  // Called when an application menu item is destroyed.
+  void release(ApplicationMenu* owner);
+
+  // Prepares the menu to be shown: polishes and lays out the menu, creates
+  // its window, loads its icons and populates the first sub-menu.
+  // Does nothing if the menu is already prepared.
+  void warmUp();
+
+  // The time between the last click and the menu being painted, in ms,
+  // or -1 if the menu hasn't been shown.
+  int popupLatencyMs() const { return popupLatencyMs_; }
+
+ public slots:
+  void reloadMenu();
 
-protected:
+  // Rebuilds only the sub-menus of the categories that have changed.
+  void onApplicationMenuEntriesChanged(const ApplicationMenuDelta& delta);
+
+  void updateStyle();
+
+ protected:
   // Intercepts sub-menus's show events to adjust their position to improve
   // visibility.
   bool eventFilter(QObject* object, QEvent* event) override;
 
  private:
-  QString getStyleSheet();
-
   QIcon loadIcon(const QString& icon);
 
+  // Loads the icons of the menu's actions.
+  void loadIcons(QMenu* menu);
+
   // Builds the menu from the application entries;
   void buildMenu();
   void addToMenu(const std::vector<Category>& categories);
+  // Adds the entries of the category to its sub-menu if not already added.
+  void populateMenu(const Category& category, QMenu* menu);
   void addEntry(const ApplicationEntry& entry, QMenu* menu);
 
-  void createContextMenu();
+  // Sets the style of the menu or sub-menu.
+  void setUpMenu(QMenu* menu);
+
+  // Shows the search popup in place of the menu.
+  void showSearchPopup();
 
   MultiDockModel* model_;
 
-  // The cascading popup menu that contains all application entries.
   QMenu menu_;
-  bool showingMenu_;
+
+  ApplicationSearchPopup searchPopup_;
+
+  // Map from category names to their sub-menus.
+  QHash<QString, QMenu*> categoryMenus_;
 
   ApplicationMenuStyle style_;
 
+  // The application menu item that is showing the menu.
+  ApplicationMenu* owner_;
+
+  bool warmedUp_;
+
+  // For measuring the popup latency.
+  QElapsedTimer popupTimer_;
+  int popupLatencyMs_;
+
   // Drag support.
 
   // Starting mouse position, used for minimum drag distance check.
   QPoint startMousePos_;
   // The desktop file associated with the application entry being dragged.
   QString draggedEntry_;
+};
+
+// The application menu item on the dock.
+//
+// Left-clicking the item shows the shared application popup menu.
+class ApplicationMenu : public QObject, public IconBasedDockItem {
+  Q_OBJECT
+
+ public:
+  ApplicationMenu(
+      DockPanel* parent,
+      MultiDockModel* model,
+      ApplicationMenuPopup* popup,
+      Qt::Orientation orientation,
+      int minSize,
+      int maxSize);
+  virtual ~ApplicationMenu();
+
+  void draw(QPainter* painter) const override;
+  void mousePressEvent(QMouseEvent* e) override;
+  void mouseHoverEvent() override { popup_->warmUp(); }
+  void loadConfig() override;
+
+  QSize getMenuSize() { return popup_->getMenuSize(); }
+
+  DockPanel* dock() { return parent_; }
+
+  // Called by the popup menu when it is shown/hidden for this item.
+  void onMenuAboutToShow();
+  void onMenuAboutToHide();
+
+ private:
+  // Creates the context menu. This is done on first use.
+  void createContextMenu();
+
+  MultiDockModel* model_;
+
+  ApplicationMenuPopup* popup_;  // No ownership.
+  bool showingMenu_;
 
-  // Context (right-click) menu.
-  QMenu contextMenu_;
+  // Context (right-click) menu, created on first use.
+  std::unique_ptr<QMenu> contextMenu_;
 };
 
 }  // namespace ksmoothdock
@@ -33,7 +33,8 @@ class ApplicationMenuSettingsDialogTest: public QObject {
  private slots:
   void init() {
     QTemporaryDir configDir;
-    model_ = std::make_unique<MultiDockModel>(configDir.path());
+    model_ = std::make_unique<MultiDockModel>(configDir.path(),
+                                              cacheDir_.path());
     model_->setApplicationMenuName("Applications");
     model_->setApplicationMenuIcon("start-here-kde");
 
@@ -54,6 +55,7 @@ class ApplicationMenuSettingsDialogTest: public QObject {
   void cancel();
 
  private:
+  QTemporaryDir cacheDir_;
   std::unique_ptr<MultiDockModel> model_;
   std::unique_ptr<ApplicationMenuSettingsDialog> dialog_;
 };
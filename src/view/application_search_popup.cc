@@ -0,0 +1,109 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "application_search_popup.h"
+
+#include <algorithm>
+
+#include <QKeyEvent>
+#include <QVBoxLayout>
+
+#include <KIconLoader>
+#include <KLocalizedString>
+
+#include "program.h"
+
+namespace ksmoothdock {
+
+constexpr int ApplicationSearchPopup::kIconSize;
+constexpr int ApplicationSearchPopup::kWidth;
+constexpr int ApplicationSearchPopup::kHeight;
+
+ApplicationSearchPopup::ApplicationSearchPopup(MultiDockModel* model)
+    : QWidget(nullptr, Qt::Popup),
+      model_(model) {
+  QVBoxLayout* layout = new QVBoxLayout(this);
+  layout->addWidget(&query_);
+  layout->addWidget(&results_);
+  query_.setPlaceholderText(i18n("Search applications"));
+  query_.setClearButtonEnabled(true);
+  query_.installEventFilter(this);
+  results_.setIconSize(QSize(kIconSize, kIconSize));
+  results_.setFocusPolicy(Qt::NoFocus);
+  resize(kWidth, kHeight);
+
+  connect(&query_, SIGNAL(textChanged(const QString&)),
+          this, SLOT(updateResults(const QString&)));
+  connect(&query_, SIGNAL(returnPressed()), this, SLOT(launchSelected()));
+  connect(&results_, &QListWidget::itemActivated, this,
+          &ApplicationSearchPopup::launch);
+}
+
+void ApplicationSearchPopup::popup(const QPoint& position) {
+  query_.clear();
+  updateResults("");
+  move(position);
+  show();
+  query_.setFocus();
+}
+
+void ApplicationSearchPopup::updateResults(const QString& query) {
+  results_.clear();
+  for (const auto* entry : model_->searchApplications(query)) {
+    QListWidgetItem* item = new QListWidgetItem(
+        QIcon(KIconLoader::global()->loadIcon(
+            entry->icon, KIconLoader::NoGroup, kIconSize)),
+        entry->name, &results_);
+    item->setToolTip(entry->genericName);
+    item->setData(Qt::UserRole, entry->command);
+  }
+  results_.setCurrentRow(0);
+}
+
+void ApplicationSearchPopup::launchSelected() {
+  QListWidgetItem* item = results_.currentItem();
+  if (item == nullptr && results_.count() > 0) {
+    item = results_.item(0);
+  }
+  if (item) {
+    launch(item);
+  }
+}
+
+bool ApplicationSearchPopup::eventFilter(QObject* object, QEvent* event) {
+  if (object == &query_ && event->type() == QEvent::KeyPress) {
+    QKeyEvent* keyEvent = dynamic_cast<QKeyEvent*>(event);
+    if (keyEvent && results_.count() > 0 &&
+        (keyEvent->key() == Qt::Key_Up || keyEvent->key() == Qt::Key_Down)) {
+      const int step = (keyEvent->key() == Qt::Key_Up) ? -1 : 1;
+      results_.setCurrentRow(
+          std::max(0, std::min(results_.count() - 1,
+                               results_.currentRow() + step)));
+      // Filter this event.
+      return true;
+    }
+  }
+  return QWidget::eventFilter(object, event);
+}
+
+void ApplicationSearchPopup::launch(QListWidgetItem* item) {
+  Program::launch(item->data(Qt::UserRole).toString());
+  hide();
+}
+
+}  // namespace ksmoothdock
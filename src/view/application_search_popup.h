@@ -0,0 +1,73 @@
+/*
+ * This file is part of KSmoothDock.
+ * Copyright (C) 2022 Viet Dang (dangvd@gmail.com)
+ *
+ * KSmoothDock is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * KSmoothDock is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with KSmoothDock.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KSMOOTHDOCK_APPLICATION_SEARCH_POPUP_H_
+#define KSMOOTHDOCK_APPLICATION_SEARCH_POPUP_H_
+
+#include <QEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QPoint>
+#include <QString>
+#include <QWidget>
+
+#include <model/multi_dock_model.h>
+
+namespace ksmoothdock {
+
+// A popup to search for applications and launch them.
+//
+// The results are updated on every keystroke from the model's in-memory
+// search index.
+class ApplicationSearchPopup : public QWidget {
+  Q_OBJECT
+
+ public:
+  // No pointer ownership.
+  explicit ApplicationSearchPopup(MultiDockModel* model);
+  virtual ~ApplicationSearchPopup() = default;
+
+  // Shows the popup at the given position with an empty query.
+  void popup(const QPoint& position);
+
+ public slots:
+  void updateResults(const QString& query);
+
+  // Launches the selected result, or the first one if none is selected.
+  void launchSelected();
+
+ protected:
+  // Intercepts the Up/Down keys in the query box to move the selection.
+  bool eventFilter(QObject* object, QEvent* event) override;
+
+ private:
+  static constexpr int kIconSize = 32;
+  static constexpr int kWidth = 400;
+  static constexpr int kHeight = 480;
+
+  void launch(QListWidgetItem* item);
+
+  MultiDockModel* model_;
+
+  QLineEdit query_;
+  QListWidget results_;
+};
+
+}  // namespace ksmoothdock
+
+#endif  // KSMOOTHDOCK_APPLICATION_SEARCH_POPUP_H_
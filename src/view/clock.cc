@@ -19,13 +19,15 @@
 #include "clock.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include <QColor>
 #include <QDate>
 #include <QFont>
+#include <QFontMetrics>
 #include <QIcon>
+#include <QPainter>
 #include <QTime>
-#include <QTimer>
 
 #include <KLocalizedString>
 
@@ -38,20 +40,26 @@ namespace ksmoothdock {
 
 constexpr float Clock::kWhRatio;
 constexpr float Clock::kDelta;
+constexpr int Clock::kMsecsPerMinute;
 
 Clock::Clock(DockPanel* parent, MultiDockModel* model,
              Qt::Orientation orientation, int minSize, int maxSize)
     : IconlessDockItem(parent, "" /* label */, orientation, minSize, maxSize,
                        kWhRatio),
       model_(model),
-      calendar_(parent),
+      use24HourClockAction_(nullptr),
+      largeFontAction_(nullptr),
+      mediumFontAction_(nullptr),
+      smallFontAction_(nullptr),
       fontFamilyGroup_(this) {
-  createMenu();
-  loadConfig();
+  // The time is shown in minutes, so the clock only needs updating on minute
+  // boundaries.
+  tickId_ = parent_->tickScheduler()->subscribe(
+      parent_, kMsecsPerMinute, [this] { updateTime(); });
+}
 
-  QTimer* timer = new QTimer(this);
-  connect(timer, SIGNAL(timeout()), this, SLOT(updateTime()));
-  timer->start(1000);  // update the time every second.
+Clock::~Clock() {
+  parent_->tickScheduler()->unsubscribe(tickId_);
 }
 
 void Clock::draw(QPainter *painter) const {
@@ -60,28 +68,25 @@ void Clock::draw(QPainter *painter) const {
   // The reference time used to calculate the font size.
   const QString referenceTime = QTime(8, 8).toString(timeFormat);
 
-  painter->setFont(adjustFontSize(getWidth(), getHeight(), referenceTime,
-                                  model_->clockFontScaleFactor(),
-                                  model_->clockFontFamily()));
-  painter->setRenderHint(QPainter::TextAntialiasing);
-
-  if (size_ > minSize_) {
-    drawBorderedText(left_, top_, getWidth(), getHeight(), Qt::AlignCenter,
-                     time, 2 /* borderWidth */, Qt::black, Qt::white, painter);
-  } else {
-    painter->setPen(Qt::white);
-    painter->drawText(left_, top_, getWidth(), getHeight(), Qt::AlignCenter,
-                      time);
-  }
+  const QFont font = adjustFontSize(getWidth(), getHeight(), referenceTime,
+                                   model_->clockFontScaleFactor(),
+                                   model_->clockFontFamily());
+  drawText(time, font, (size_ > minSize_) ? 2 : 0 /* borderWidth */, painter);
 }
 
 void Clock::mousePressEvent(QMouseEvent *e) {
   if (e->button() == Qt::LeftButton) {
-    calendar_.toggleCalendar();
+    if (!calendar_) {
+      calendar_ = std::make_unique<Calendar>(parent_);
+    }
+    calendar_->toggleCalendar();
   } else if (e->button() == Qt::RightButton) {
+    if (!menu_) {
+      createMenu();
+    }
     // In case other docks have changed the config.
     loadConfig();
-    menu_.popup(e->globalPos());
+    menu_->popup(e->globalPos());
   }
 }
 
@@ -90,7 +95,7 @@ QString Clock::getLabel() const {
 }
 
 void Clock::updateTime() {
-  parent_->update();
+  parent_->update(left_, top_, getWidth(), getHeight());
 }
 
 void Clock::setDateAndTime() {
@@ -123,19 +128,20 @@ void Clock::setSmallFont() {
 }
 
 void Clock::createMenu() {
-  menu_.addAction(QIcon::fromTheme("preferences-system-time"),
+  menu_ = std::make_unique<QMenu>();
+  menu_->addAction(QIcon::fromTheme("preferences-system-time"),
                   i18n("Date and Time &Settings"),
                   this,
                   SLOT(setDateAndTime()));
 
-  use24HourClockAction_ = menu_.addAction(
+  use24HourClockAction_ = menu_->addAction(
       i18n("Use 24-hour Clock"), this,
       [this] {
         saveConfig();
       });
   use24HourClockAction_->setCheckable(true);
 
-  QMenu* fontSize = menu_.addMenu(i18n("Font Size"));
+  QMenu* fontSize = menu_->addMenu(i18n("Font Size"));
   largeFontAction_ = fontSize->addAction(i18n("Large Font"),
                                          this,
                                          SLOT(setLargeFont()));
@@ -149,22 +155,91 @@ void Clock::createMenu() {
                                          SLOT(setSmallFont()));
   smallFontAction_->setCheckable(true);
 
-  QMenu* fontFamily = menu_.addMenu(i18n("Font Family"));
-  for (const auto& family : getBaseFontFamilies()) {
-    auto fontFamilyAction = fontFamily->addAction(family, this, [this, family]{
-      model_->setClockFontFamily(family);
-      model_->saveAppearanceConfig(true /* repaintOnly */);
-    });
-    fontFamilyAction->setCheckable(true);
-    fontFamilyAction->setActionGroup(&fontFamilyGroup_);
-    fontFamilyAction->setChecked(family == model_->clockFontFamily());
+  // There can be a thousand font families, so the submenu is populated on
+  // first show.
+  QMenu* fontFamily = menu_->addMenu(i18n("Font Family"));
+  connect(fontFamily, &QMenu::aboutToShow, this, [this, fontFamily] {
+    if (!fontFamily->isEmpty()) {
+      return;
+    }
+
+    for (const auto& family : getBaseFontFamilies()) {
+      auto fontFamilyAction = fontFamily->addAction(family, this,
+                                                    [this, family] {
+        model_->setClockFontFamily(family);
+        model_->saveAppearanceConfig(true /* repaintOnly */);
+      });
+      fontFamilyAction->setCheckable(true);
+      fontFamilyAction->setActionGroup(&fontFamilyGroup_);
+      fontFamilyAction->setChecked(family == model_->clockFontFamily());
+    }
+  });
+
+  menu_->addSeparator();
+  parent_->addPanelSettings(menu_.get());
+}
+
+void Clock::drawText(const QString& text, const QFont& font, int borderWidth,
+                     QPainter* painter) const {
+  if (text.isEmpty()) {
+    return;
+  }
+
+  const QPixmap& pixmap = renderedText(
+      text, font, borderWidth, painter->device()->devicePixelRatioF());
+  const QSizeF size = pixmap.size() / pixmap.devicePixelRatio();
+  const int x = left_ + (getWidth() - static_cast<int>(size.width())) / 2;
+  const int y = top_ + (getHeight() - static_cast<int>(size.height())) / 2;
+  painter->drawPixmap(x, y, pixmap);
+}
+
+const QPixmap& Clock::renderedText(const QString& text, const QFont& font,
+                                   int borderWidth,
+                                   qreal devicePixelRatio) const {
+  // Fonts change with the item size while zooming, so this only bounds the
+  // cache in case of many appearance changes.
+  constexpr int kMaxFonts = 256;
+
+  const QString fontKey = font.key() + ':' + QString::number(borderWidth) +
+      ':' + QString::number(devicePixelRatio);
+  if (!renderedTexts_.contains(fontKey) &&
+      renderedTexts_.size() >= kMaxFonts) {
+    renderedTexts_.clear();
+  }
+  auto& rendered = renderedTexts_[fontKey];
+  if (rendered.text == text && !rendered.pixmap.isNull()) {
+    return rendered.pixmap;
   }
 
-  menu_.addSeparator();
-  parent_->addPanelSettings(&menu_);
+  const QFontMetrics metrics(font);
+  const int width = metrics.horizontalAdvance(text) + 2 * borderWidth;
+  const int height = metrics.height() + 2 * borderWidth;
+  const int baseline = borderWidth + metrics.ascent();
+
+  rendered.text = text;
+  rendered.pixmap =
+      QPixmap(static_cast<int>(std::ceil(width * devicePixelRatio)),
+              static_cast<int>(std::ceil(height * devicePixelRatio)));
+  rendered.pixmap.setDevicePixelRatio(devicePixelRatio);
+  rendered.pixmap.fill(Qt::transparent);
+  QPainter painter(&rendered.pixmap);
+  painter.setFont(font);
+  painter.setRenderHint(QPainter::TextAntialiasing);
+  if (borderWidth > 0) {
+    drawBorderedText(borderWidth, baseline, text, borderWidth, Qt::black,
+                     Qt::white, &painter);
+  } else {
+    painter.setPen(Qt::white);
+    painter.drawText(0, baseline, text);
+  }
+  return rendered.pixmap;
 }
 
 void Clock::loadConfig() {
+  if (!menu_) {
+    return;
+  }
+
   use24HourClockAction_->setChecked(model_->use24HourClock());
   setFontScaleFactor(model_->clockFontScaleFactor());
 }
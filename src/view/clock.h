@@ -21,10 +21,15 @@
 
 #include "iconless_dock_item.h"
 
+#include <memory>
+
 #include <QAction>
 #include <QActionGroup>
+#include <QFont>
+#include <QHash>
 #include <QMenu>
 #include <QObject>
+#include <QPixmap>
 #include <QString>
 
 #include "calendar.h"
@@ -39,7 +44,7 @@ class Clock : public QObject, public IconlessDockItem {
  public:
   Clock(DockPanel* parent, MultiDockModel* model, Qt::Orientation orientation,
         int minSize, int maxSize);
-  virtual ~Clock() = default;
+  virtual ~Clock();
 
   void draw(QPainter* painter) const override;
   void mousePressEvent(QMouseEvent* e) override;
@@ -60,6 +65,13 @@ class Clock : public QObject, public IconlessDockItem {
  private:
   static constexpr float kWhRatio = 2.8;
   static constexpr float kDelta = 0.01;
+  static constexpr int kMsecsPerMinute = 60 * 1000;
+
+  // The pre-rendered time, with its border.
+  struct RenderedText {
+    QString text;
+    QPixmap pixmap;
+  };
 
   float fontScaleFactor() {
     return largeFontAction_->isChecked()
@@ -68,17 +80,28 @@ class Clock : public QObject, public IconlessDockItem {
                                          : kSmallClockFontScaleFactor;
   }
 
-  // Creates the context menu.
+  // Creates the context menu. This is done on first use.
   void createMenu();
 
   void saveConfig();
 
+  // Draws the text centered in the clock from a cached pixmap, so that
+  // zooming doesn't re-rasterise it.
+  void drawText(const QString& text, const QFont& font, int borderWidth,
+                QPainter* painter) const;
+
+  // Renders the whole text, so that it keeps its kerning, at the device
+  // pixel ratio of the painter, so that it's sharp on HiDPI screens.
+  const QPixmap& renderedText(const QString& text, const QFont& font,
+                              int borderWidth, qreal devicePixelRatio) const;
+
   MultiDockModel* model_;
 
-  Calendar calendar_;
+  // Created on first use.
+  std::unique_ptr<Calendar> calendar_;
 
-  // Context menu.
-  QMenu menu_;
+  // Context menu, created on first use.
+  std::unique_ptr<QMenu> menu_;
 
   QAction* use24HourClockAction_;
   QAction* largeFontAction_;
@@ -86,6 +109,13 @@ class Clock : public QObject, public IconlessDockItem {
   QAction* smallFontAction_;
 
   QActionGroup fontFamilyGroup_;
+
+  // The subscription to the dock's tick scheduler.
+  int tickId_;
+
+  // The last rendered text by font, border width and device pixel ratio.
+  // The text changes once a minute, so only the last one is kept.
+  mutable QHash<QString, RenderedText> renderedTexts_;
 };
 
 }  // namespace ksmoothdock
@@ -24,6 +24,7 @@
 #include <QIcon>
 #include <QPainter>
 #include <QPixmap>
+#include <QRect>
 
 #include <KLocalizedString>
 #include <KWindowSystem>
@@ -34,22 +35,46 @@
 
 namespace ksmoothdock {
 
+constexpr int DesktopSelector::kWindowLayoutUpdateIntervalMs;
+
 DesktopSelector::DesktopSelector(DockPanel* parent, MultiDockModel* model,
+                                 WallpaperThumbnailCache* thumbnails,
+                                 WindowLayoutTracker* windows,
                                  Qt::Orientation orientation, int minSize,
                                  int maxSize, int desktop, int screen)
     : IconBasedDockItem(parent, 
           i18n("Desktop ") + QString::number(desktop),
           orientation, "" /* no icon yet */, minSize, maxSize),
       model_(model),
+      thumbnails_(thumbnails),
+      windows_(windows),
       desktop_(desktop),
       screen_(screen),
+      showDesktopNumberAction_(nullptr),
       desktopWidth_(parent->screenGeometry().width()),
       desktopHeight_(parent->screenGeometry().height()),
-      hasCustomWallpaper_(false) {
-  createMenu();
+      hasCustomWallpaper_(false),
+      windowLayerValid_(false) {
+  connect(thumbnails_, &WallpaperThumbnailCache::thumbnailReady,
+          this, &DesktopSelector::onThumbnailReady);
+  connect(windows_, &WindowLayoutTracker::layoutChanged,
+          this, &DesktopSelector::onWindowLayoutChanged);
+  windowLayoutTimer_.setSingleShot(true);
+  windowLayoutTimer_.setInterval(kWindowLayoutUpdateIntervalMs);
+  connect(&windowLayoutTimer_, &QTimer::timeout, this, [this] {
+    // The window layer is re-rendered once on the next paint.
+    windowLayerValid_ = false;
+    parent_->update(left_, top_, getWidth(), getHeight());
+  });
   loadConfig();
 }
 
+DesktopSelector::~DesktopSelector() {
+  if (!wallpaper_.isEmpty()) {
+    thumbnails_->release(wallpaper_, wallpaperSize_);
+  }
+}
+
 void DesktopSelector::draw(QPainter* painter) const {
   if (hasCustomWallpaper_) {
     IconBasedDockItem::draw(painter);
@@ -60,6 +85,12 @@ void DesktopSelector::draw(QPainter* painter) const {
     painter->fillRect(left_, top_, getWidth(), getHeight(), QBrush(fillColor));
   }
 
+  if (!windowLayerValid_) {
+    renderWindowLayer();
+  }
+  painter->drawPixmap(QRect(left_, top_, getWidth(), getHeight()),
+                      windowLayer_);
+
   if (model_->showDesktopNumber()) {
     painter->setFont(adjustFontSize(getWidth(), getHeight(),
                                     "0" /* reference string */,
@@ -85,20 +116,35 @@ void DesktopSelector::mousePressEvent(QMouseEvent* e) {
       KWindowSystem::setCurrentDesktop(desktop_);
     }
   } else if (e->button() == Qt::RightButton) {
+    if (!menu_) {
+      createMenu();
+    }
     // In case other DesktopSelectors have changed the config.
     showDesktopNumberAction_->setChecked(model_->showDesktopNumber());
-    menu_.popup(e->globalPos());
+    menu_->popup(e->globalPos());
   }
 }
 
 void DesktopSelector::loadConfig() {
   const auto& wallpaper = model_->wallpaper(desktop_, screen_);
   if (!wallpaper.isEmpty() && QFile::exists(wallpaper)) {
-    setIconScaled(QPixmap(wallpaper));
-    hasCustomWallpaper_ = true;
+    // Until the thumbnail is ready, the current one or the plain numbered
+    // rectangle is shown.
+    const QSize size = thumbnailSize();
+    if (wallpaper != wallpaper_ || size != wallpaperSize_) {
+      if (!wallpaper_.isEmpty()) {
+        thumbnails_->release(wallpaper_, wallpaperSize_);
+      }
+      thumbnails_->acquire(wallpaper, size);
+      wallpaper_ = wallpaper;
+      wallpaperSize_ = size;
+    }
+    onThumbnailReady(wallpaper_, wallpaperSize_);
   }
 
-  showDesktopNumberAction_->setChecked(model_->showDesktopNumber());
+  if (showDesktopNumberAction_) {
+    showDesktopNumberAction_->setChecked(model_->showDesktopNumber());
+  }
 }
 
 void DesktopSelector::saveConfig() {
@@ -106,32 +152,86 @@ void DesktopSelector::saveConfig() {
   model_->saveAppearanceConfig(true /* repaintOnly */);
 }
 
-void DesktopSelector::setIconScaled(const QPixmap& icon) {
-  if (icon.width() * desktopHeight_ != icon.height() * desktopWidth_) {
-    QPixmap scaledIcon = icon.scaled(desktopWidth_, desktopHeight_);
-    setIcon(scaledIcon);
-  } else {
-    setIcon(icon);
+void DesktopSelector::onThumbnailReady(const QString& wallpaper,
+                                       const QSize& size) {
+  if (wallpaper != wallpaper_ || size != wallpaperSize_) {
+    return;
+  }
+
+  // The thumbnail has the largest icon size and the screen's width/height
+  // ratio.
+  const QPixmap thumbnail = thumbnails_->thumbnail(wallpaper, size);
+  if (!thumbnail.isNull()) {
+    setIcon(thumbnail);
+    hasCustomWallpaper_ = true;
+    parent_->update();
+  }
+}
+
+void DesktopSelector::onWindowLayoutChanged(int desktop) {
+  // Not restarted if already running, so that a continuous stream of
+  // changes is still repainted periodically.
+  if ((desktop == desktop_ || desktop == NET::OnAllDesktops) &&
+      !windowLayoutTimer_.isActive()) {
+    windowLayoutTimer_.start();
+  }
+}
+
+void DesktopSelector::renderWindowLayer() const {
+  windowLayer_ = QPixmap(thumbnailSize());
+  windowLayer_.fill(Qt::transparent);
+  windowLayerValid_ = true;
+
+  const QRect screenGeometry = parent_->screenGeometry();
+  const qreal scale = static_cast<qreal>(windowLayer_.width()) /
+      screenGeometry.width();
+  QColor fillColor = model_->backgroundColor();
+  fillColor.setAlphaF(0.8);
+  QPainter painter(&windowLayer_);
+  painter.setPen(model_->borderColor());
+  for (const auto* window : windows_->windows(desktop_)) {
+    const QRect geometry = window->geometry.intersected(screenGeometry)
+        .translated(-screenGeometry.topLeft());
+    if (geometry.isEmpty()) {
+      continue;
+    }
+
+    const QRect miniature(qRound(geometry.x() * scale),
+                          qRound(geometry.y() * scale),
+                          qRound(geometry.width() * scale),
+                          qRound(geometry.height() * scale));
+    painter.fillRect(miniature, fillColor);
+    painter.drawRect(miniature.adjusted(0, 0, -1, -1));
+
+    // Only shows the icon if it fits the miniature.
+    constexpr int kIconSize = WindowLayoutTracker::kIconSize;
+    if (!window->icon.isNull() && miniature.width() >= kIconSize + 4 &&
+        miniature.height() >= kIconSize + 4) {
+      painter.drawPixmap(miniature.center().x() - kIconSize / 2,
+                         miniature.center().y() - kIconSize / 2,
+                         window->icon);
+    }
   }
 }
 
 void DesktopSelector::createMenu() {
-  menu_.addAction(
+  menu_ = std::make_unique<QMenu>();
+  menu_->addAction(
       QIcon::fromTheme("preferences-desktop-wallpaper"),
       i18n("Set Wallpaper for Desktop ") + QString::number(desktop_),
       parent_,
       [this] {
         parent_->showWallpaperSettingsDialog(desktop_);
       });
-  showDesktopNumberAction_ = menu_.addAction(
+  showDesktopNumberAction_ = menu_->addAction(
       i18n("Show Desktop Number"), this,
       [this] {
         saveConfig();
       });
   showDesktopNumberAction_->setCheckable(true);
 
-  menu_.addSeparator();
-  parent_->addPanelSettings(&menu_);
+  menu_->addSeparator();
+  parent_->addPanelSettings(menu_.get());
 }
 
 }  // namespace ksmoothdock
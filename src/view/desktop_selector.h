@@ -26,11 +26,16 @@
 #include <QAction>
 #include <QMenu>
 #include <QObject>
+#include <QPixmap>
+#include <QSize>
 #include <QString>
+#include <QTimer>
 
 #include <KWindowSystem>
 
 #include <model/multi_dock_model.h>
+#include <utils/wallpaper_thumbnail_cache.h>
+#include <utils/window_layout_tracker.h>
 
 namespace ksmoothdock {
 
@@ -40,10 +45,12 @@ class DesktopSelector : public QObject, public IconBasedDockItem {
 
  public:
   DesktopSelector(DockPanel* parent, MultiDockModel* model,
+                  WallpaperThumbnailCache* thumbnails,
+                  WindowLayoutTracker* windows,
                   Qt::Orientation orientation, int minSize, int maxSize,
                   int desktop, int screen);
 
-  virtual ~DesktopSelector() = default;
+  virtual ~DesktopSelector();
 
   int getWidthForSize(int size) const override {
     return isHorizontal() ? (size * desktopWidth_ / desktopHeight_) : size;
@@ -57,19 +64,36 @@ class DesktopSelector : public QObject, public IconBasedDockItem {
   void mousePressEvent(QMouseEvent* e) override;
   void loadConfig() override;
 
-  // Sets the icon but scales the pixmap to the screen's width/height ratio.
-  void setIconScaled(const QPixmap& icon);
+ private slots:
+  void onThumbnailReady(const QString& wallpaper, const QSize& size);
+
+  void onWindowLayoutChanged(int desktop);
 
  private:
+  // Window layout changes, e.g. while a window is being dragged, are
+  // repainted at most this often.
+  static constexpr int kWindowLayoutUpdateIntervalMs = 100;
+
   bool isCurrentDesktop() const {
     return KWindowSystem::currentDesktop() == desktop_;
   }
 
+  // Creates the context menu. This is done on first use.
   void createMenu();
 
   void saveConfig();
 
+  // The wallpaper thumbnail size needed for the icons.
+  QSize thumbnailSize() const {
+    return QSize(getWidthForSize(maxSize_), getHeightForSize(maxSize_));
+  }
+
+  // Renders the miniatures of the desktop's windows into windowLayer_.
+  void renderWindowLayer() const;
+
   MultiDockModel* model_;
+  WallpaperThumbnailCache* thumbnails_;  // No ownership.
+  WindowLayoutTracker* windows_;  // No ownership.
 
   // The desktop that this desktop selector manages, 1-based.
   int desktop_;
@@ -77,15 +101,28 @@ class DesktopSelector : public QObject, public IconBasedDockItem {
   int screen_;
   KConfig* config_;
 
-  // Context (right-click) menu.
-  QMenu menu_;
+  // Context (right-click) menu, created on first use.
+  std::unique_ptr<QMenu> menu_;
 
   QAction* showDesktopNumberAction_;
 
   int desktopWidth_;
   int desktopHeight_;
 
+  // The wallpaper whose thumbnail is shown or being produced, and the size
+  // that it is acquired at from thumbnails_.
+  QString wallpaper_;
+  QSize wallpaperSize_;
   bool hasCustomWallpaper_;
+
+  // Window miniatures at the largest icon size, only re-rendered when one of
+  // the desktop's windows has changed.
+  mutable QPixmap windowLayer_;
+  mutable bool windowLayerValid_;
+  // For coalescing window layout changes.
+  QTimer windowLayoutTimer_;
+
+  friend class DesktopSelectorTest;
 };
 
 }  // namespace ksmoothdock
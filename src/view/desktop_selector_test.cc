@@ -22,6 +22,7 @@
 #include <cstdlib>
 #include <memory>
 
+#include <QImage>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
@@ -42,37 +43,55 @@ class DesktopSelectorTest: public QObject {
  private slots:
   void init() {
     QTemporaryDir configDir;
-    model_ = std::make_unique<MultiDockModel>(configDir.path());
+    model_ = std::make_unique<MultiDockModel>(configDir.path(),
+                                              cacheDir_.path());
     model_->addDock();
     view_ = std::make_unique<MultiDockView>(model_.get());
     dock_ = std::make_unique<DockPanel>(view_.get(), model_.get(), kDockId);
   }
 
-  // Tests that the icon is scaled to screen's width/height ratio if needed.
-  void setIconScaled();
+  // Tests that the wallpaper is decoded directly at the thumbnail size, in
+  // the screen's width/height ratio.
+  void loadConfig_scaledWallpaper();
 
  private:
+  QTemporaryDir cacheDir_;
   std::unique_ptr<MultiDockModel> model_;
   std::unique_ptr<MultiDockView> view_;
   std::unique_ptr<DockPanel> dock_;
 };
 
-void DesktopSelectorTest::setIconScaled() {
-  QTemporaryFile iconFile;
-  QVERIFY(iconFile.open());
-  QPixmap icon(100, 100);
-  icon.save(iconFile.fileName(), "PNG");
-  model_->setWallpaper(kDesktop, kScreen, iconFile.fileName());
+void DesktopSelectorTest::loadConfig_scaledWallpaper() {
+  QTemporaryFile wallpaperFile;
+  QVERIFY(wallpaperFile.open());
+  // Much larger than the icons, and not in the screen's width/height ratio.
+  QImage wallpaper(2000, 500, QImage::Format_RGB32);
+  wallpaper.fill(Qt::blue);
+  QVERIFY(wallpaper.save(wallpaperFile.fileName(), "PNG"));
+  model_->setWallpaper(kDesktop, kScreen, wallpaperFile.fileName());
 
-  DesktopSelector desktopSelector(dock_.get(), model_.get(), Qt::Horizontal,
-                                  kMinSize, kMaxSize, kDesktop, kScreen);
+  DesktopSelector desktopSelector(dock_.get(), model_.get(),
+                                  view_->wallpaperThumbnailCache(),
+                                  view_->windowLayoutTracker(),
+                                  Qt::Horizontal, kMinSize, kMaxSize, kDesktop,
+                                  kScreen);
 
-  QCOMPARE(desktopSelector.getIcon(kMinSize).height(), kMinSize);
+  // The thumbnail is produced in the background.
+  QTRY_COMPARE(desktopSelector.getIcon(kMinSize).height(), kMinSize);
   const int desktopWidth = dock_->screenGeometry().width();
   const int desktopHeight = dock_->screenGeometry().height();
   // Gives room to rounding difference.
   QVERIFY(std::abs(desktopSelector.getIcon(kMinSize).width() -
                    desktopWidth * kMinSize / desktopHeight) <= 1);
+
+  // The thumbnail itself was decoded at the largest icon size rather than at
+  // the wallpaper's size.
+  const QSize thumbnailSize(desktopWidth * kMaxSize / desktopHeight, kMaxSize);
+  const QPixmap thumbnail = view_->wallpaperThumbnailCache()->thumbnail(
+      wallpaperFile.fileName(), desktopSelector.thumbnailSize());
+  QVERIFY(!thumbnail.isNull());
+  QCOMPARE(thumbnail.height(), thumbnailSize.height());
+  QVERIFY(std::abs(thumbnail.width() - thumbnailSize.width()) <= 1);
 }
 
 }  // namespace ksmoothdock
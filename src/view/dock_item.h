@@ -54,6 +54,9 @@ class DockItem {
   // Mouse press event handler.
   virtual void mousePressEvent(QMouseEvent* e) = 0;
 
+  // Called when the mouse moves over the item, e.g. to get ready for a click.
+  virtual void mouseHoverEvent() {}
+
   // Some dock items (e.g. Application Menu or Clock) have their own global
   // (i.e. not dock-specific) config that they need to reload when the config
   // has been changed by another dock (not their parent dock).
@@ -167,6 +170,7 @@ class DockItem {
 
  private:
   friend class DockPanel;
+  friend class DockPanelTest;
 };
 
 }  // namespace ksmoothdock
@@ -50,6 +50,7 @@
 #include "program.h"
 #include "separator.h"
 #include <utils/command_utils.h>
+#include <utils/font_utils.h>
 #include <utils/task_helper.h>
 
 namespace ksmoothdock {
@@ -64,16 +65,12 @@ DockPanel::DockPanel(MultiDockView* parent, MultiDockModel* model, int dockId)
       dockId_(dockId),
       visibility_(PanelVisibility::AlwaysVisible),
       showPager_(false),
+      desktopCount_(0),
       showClock_(false),
       showBorder_(true),
-      aboutDialog_(KAboutData::applicationData(), this),
-      addPanelDialog_(this, model, dockId),
-      appearanceSettingsDialog_(this, model),
-      editLaunchersDialog_(this, model, dockId),
-      applicationMenuSettingsDialog_(this, model),
-      wallpaperSettingsDialog_(this, model),
-      taskManagerSettingsDialog_(this, model),
       isMinimized_(true),
+      isSuspended_(false),
+      layoutPending_(false),
       isResizing_(false),
       isEntering_(false),
       isLeaving_(false),
@@ -91,11 +88,11 @@ DockPanel::DockPanel(MultiDockView* parent, MultiDockModel* model, int dockId)
   connect(animationTimer_.get(), SIGNAL(timeout()), this,
       SLOT(updateAnimation()));
   connect(KWindowSystem::self(), SIGNAL(numberOfDesktopsChanged(int)),
-      this, SLOT(updatePager()));
+      this, SLOT(updatePager(int)));
   connect(KWindowSystem::self(), SIGNAL(currentDesktopChanged(int)),
           this, SLOT(onCurrentDesktopChanged()));
   connect(KWindowSystem::self(), SIGNAL(activeWindowChanged(WId)),
-          this, SLOT(update()));
+          this, SLOT(onActiveWindowChanged()));
   connect(KWindowSystem::self(), SIGNAL(windowAdded(WId)),
           this, SLOT(onWindowAdded(WId)));
   connect(KWindowSystem::self(), SIGNAL(windowRemoved(WId)),
@@ -108,6 +105,8 @@ DockPanel::DockPanel(MultiDockView* parent, MultiDockModel* model, int dockId)
           this, &DockPanel::onCurrentActivityChanged);
   connect(model_, SIGNAL(appearanceOutdated()), this, SLOT(update()));
   connect(model_, SIGNAL(appearanceChanged()), this, SLOT(reload()));
+  connect(model_, SIGNAL(iconOverrideRulesChanged()),
+          this, SLOT(onIconOverrideRulesChanged()));
   connect(model_, SIGNAL(dockLaunchersChanged(int)),
           this, SLOT(onDockLaunchersChanged(int)));
 }
@@ -173,6 +172,7 @@ QPoint DockPanel::applicationSubMenuPosition(
 
 void DockPanel::reload() {
   loadAppearanceConfig();
+  clearAdjustedFontCache();
   items_.clear();
   initUi();
   update();
@@ -200,6 +200,11 @@ void DockPanel::onCurrentActivityChanged() {
   reloadTasks();
 }
 
+void DockPanel::onIconOverrideRulesChanged() {
+  // Re-resolves the tasks' programs with the new rules.
+  reloadTasks();
+}
+
 void DockPanel::setStrut() {
   switch(visibility_) {
     case PanelVisibility::AlwaysVisible:
@@ -234,6 +239,10 @@ void DockPanel::togglePager() {
   saveDockConfig();
 }
 
+TickScheduler* DockPanel::tickScheduler() {
+  return parent_->tickScheduler();
+}
+
 void DockPanel::setScreen(int screen) {
   screen_ = screen;
   for (int i = 0; i < static_cast<int>(screenActions_.size()); ++i) {
@@ -276,47 +285,77 @@ void DockPanel::showOnlineDocumentation() {
 }
 
 void DockPanel::about() {
-  aboutDialog_.show();
-  KWindowSystem::forceActiveWindow(aboutDialog_.winId());
+  if (!aboutDialog_) {
+    aboutDialog_ = std::make_unique<KAboutApplicationDialog>(
+        KAboutData::applicationData(), this);
+  }
+  aboutDialog_->show();
+  KWindowSystem::forceActiveWindow(aboutDialog_->winId());
 }
 
 void DockPanel::showAppearanceSettingsDialog() {
-  appearanceSettingsDialog_.reload();
-  appearanceSettingsDialog_.show();
-  KWindowSystem::forceActiveWindow(appearanceSettingsDialog_.winId());
+  if (!appearanceSettingsDialog_) {
+    appearanceSettingsDialog_ =
+        std::make_unique<AppearanceSettingsDialog>(this, model_);
+  }
+  appearanceSettingsDialog_->reload();
+  appearanceSettingsDialog_->show();
+  KWindowSystem::forceActiveWindow(appearanceSettingsDialog_->winId());
 }
 
 void DockPanel::showEditLaunchersDialog() {
-  editLaunchersDialog_.reload();
-  editLaunchersDialog_.show();
-  KWindowSystem::forceActiveWindow(editLaunchersDialog_.winId());
+  if (!editLaunchersDialog_) {
+    editLaunchersDialog_ =
+        std::make_unique<EditLaunchersDialog>(this, model_, dockId_);
+  }
+  editLaunchersDialog_->reload();
+  editLaunchersDialog_->show();
+  KWindowSystem::forceActiveWindow(editLaunchersDialog_->winId());
 }
 
 void DockPanel::showApplicationMenuSettingsDialog() {
-  applicationMenuSettingsDialog_.reload();
-  applicationMenuSettingsDialog_.show();
-  KWindowSystem::forceActiveWindow(applicationMenuSettingsDialog_.winId());
+  if (!applicationMenuSettingsDialog_) {
+    applicationMenuSettingsDialog_ =
+        std::make_unique<ApplicationMenuSettingsDialog>(this, model_);
+  }
+  applicationMenuSettingsDialog_->reload();
+  applicationMenuSettingsDialog_->show();
+  KWindowSystem::forceActiveWindow(applicationMenuSettingsDialog_->winId());
 }
 
 void DockPanel::showWallpaperSettingsDialog(int desktop) {
-  wallpaperSettingsDialog_.setFor(desktop, screen_);
-  wallpaperSettingsDialog_.show();
-  KWindowSystem::forceActiveWindow(wallpaperSettingsDialog_.winId());
+  if (!wallpaperSettingsDialog_) {
+    wallpaperSettingsDialog_ =
+        std::make_unique<WallpaperSettingsDialog>(this, model_);
+  }
+  wallpaperSettingsDialog_->setFor(desktop, screen_);
+  wallpaperSettingsDialog_->show();
+  KWindowSystem::forceActiveWindow(wallpaperSettingsDialog_->winId());
 }
 
 void DockPanel::showTaskManagerSettingsDialog() {
-  taskManagerSettingsDialog_.show();
-  KWindowSystem::forceActiveWindow(taskManagerSettingsDialog_.winId());
+  if (!taskManagerSettingsDialog_) {
+    taskManagerSettingsDialog_ =
+        std::make_unique<TaskManagerSettingsDialog>(this, model_);
+  }
+  taskManagerSettingsDialog_->show();
+  KWindowSystem::forceActiveWindow(taskManagerSettingsDialog_->winId());
 }
 
 void DockPanel::addDock() {
-  addPanelDialog_.setMode(AddPanelDialog::Mode::Add);
-  addPanelDialog_.show();
+  showAddPanelDialog(AddPanelDialog::Mode::Add);
 }
 
 void DockPanel::cloneDock() {
-  addPanelDialog_.setMode(AddPanelDialog::Mode::Clone);
-  addPanelDialog_.show();
+  showAddPanelDialog(AddPanelDialog::Mode::Clone);
+}
+
+void DockPanel::showAddPanelDialog(AddPanelDialog::Mode mode) {
+  if (!addPanelDialog_) {
+    addPanelDialog_ = std::make_unique<AddPanelDialog>(this, model_, dockId_);
+  }
+  addPanelDialog_->setMode(mode);
+  addPanelDialog_->show();
 }
 
 void DockPanel::removeDock() {
@@ -362,6 +401,12 @@ void DockPanel::onWindowRemoved(WId wId) {
 
 void DockPanel::onWindowChanged(WId wId, NET::Properties properties,
                                 NET::Properties2 properties2) {
+  if (wId == KWindowSystem::activeWindow() &&
+      (properties & NET::WMState || properties & NET::WMGeometry)) {
+    // The active window might have gone fullscreen or moved over the dock.
+    updateSuspended();
+  }
+
   if (!showTaskManager()) {
     return;
   }
@@ -379,9 +424,17 @@ void DockPanel::onWindowChanged(WId wId, NET::Properties properties,
     } else if (properties & NET::WMState) {
       updateTask(wId);
     }
+    if (properties & (NET::WMName | NET::WMVisibleName)) {
+      updateTaskIconOverride(wId);
+    }
   }
 }
 
+void DockPanel::onActiveWindowChanged() {
+  updateSuspended();
+  update();
+}
+
 void DockPanel::paintEvent(QPaintEvent* e) {
   if (isResizing_) {
     return;  // to avoid potential flicker.
@@ -413,6 +466,10 @@ void DockPanel::paintEvent(QPaintEvent* e) {
     }
   }
 
+  if (isSuspended_) {
+    return;  // only the auto-hide strip, if any, can be seen.
+  }
+
   // Draw the items from the end to avoid zoomed items getting clipped by
   // non-zoomed items.
   for (int i = itemCount() - 1; i >= 0; --i) {
@@ -436,10 +493,15 @@ void DockPanel::mouseMoveEvent(QMouseEvent* e) {
     return;
   }
 
+  const int i = findActiveItem(e->x(), e->y());
   if (!isEntering_) {
-    showTooltip(e->x(), e->y());
+    showOrHideTooltip(i);
   }
   updateLayout(e->x(), e->y());
+
+  if (i >= 0 && i < itemCount()) {
+    items_[i]->mouseHoverEvent();
+  }
 }
 
 void DockPanel::mousePressEvent(QMouseEvent* e) {
@@ -457,6 +519,9 @@ void DockPanel::mousePressEvent(QMouseEvent* e) {
 
 void DockPanel::enterEvent (QEvent* e) {
   isEntering_ = true;
+  // Lays out the items that changed while the dock was suspended before the
+  // entering animation starts from their positions.
+  updateSuspended();
   if (windowsCanCover()) {
     KWindowSystem::setState(winId(), NET::KeepAbove);
   }
@@ -468,6 +533,8 @@ void DockPanel::leaveEvent(QEvent* e) {
   }
 
   if (isMinimized_) {
+    isEntering_ = false;
+    updateSuspended();
     return;
   }
 
@@ -476,6 +543,84 @@ void DockPanel::leaveEvent(QEvent* e) {
   tooltip_.hide();
 }
 
+void DockPanel::showEvent(QShowEvent* e) {
+  QWidget::showEvent(e);
+  updateSuspended();
+}
+
+void DockPanel::hideEvent(QHideEvent* e) {
+  QWidget::hideEvent(e);
+  updateSuspended();
+}
+
+void DockPanel::changeEvent(QEvent* e) {
+  if (e->type() == QEvent::ApplicationFontChange) {
+    clearAdjustedFontCache();
+    update();
+  }
+  QWidget::changeEvent(e);
+}
+
+bool DockPanel::isCoveredByActiveWindow() {
+  const WId wId = KWindowSystem::activeWindow();
+  if (wId == 0 || wId == winId()) {
+    return false;
+  }
+
+  // Queried here rather than taken from the pager's window tracker, which
+  // leaves out e.g. the windows that skip the pager, and might not have
+  // handled the same window event yet.
+  KWindowInfo info(wId, NET::WMState | NET::XAWMState | NET::WMFrameExtents);
+  if (!info.valid() || info.isMinimized()) {
+    return false;
+  }
+
+  const auto stackingOrder = KWindowSystem::stackingOrder();
+  return isCoveredBy(
+      info.frameGeometry(), info.hasState(NET::FullScreen),
+      stackingOrder.indexOf(wId) > stackingOrder.indexOf(winId()));
+}
+
+bool DockPanel::isCoveredBy(const QRect& frameGeometry, bool fullScreen,
+                            bool aboveDock) const {
+  if (!aboveDock || !frameGeometry.contains(geometry())) {
+    return false;
+  }
+
+  // A fullscreen window goes above the dock whatever its visibility mode.
+  return fullScreen ||
+      visibility_ == PanelVisibility::WindowsCanCover ||
+      visibility_ == PanelVisibility::WindowsCanCover_Quiet;
+}
+
+void DockPanel::updateSuspended() {
+  // An auto-hidden dock is only a thin strip, so its items can't be seen.
+  const bool suspended = !isVisible() || (isMinimized_ && !isEntering_ &&
+      (autoHide() || isCoveredByActiveWindow()));
+  if (suspended == isSuspended_) {
+    return;
+  }
+
+  isSuspended_ = suspended;
+  if (isSuspended_) {
+    tickScheduler()->pause(this);
+  } else {
+    tickScheduler()->resume(this);
+    catchUpLayout();
+    update();
+  }
+}
+
+void DockPanel::catchUpLayout() {
+  if (!layoutPending_) {
+    return;
+  }
+
+  layoutPending_ = false;
+  // All the items might have changed, so none of them keeps its position.
+  resizeTaskManager(0);
+}
+
 void DockPanel::initUi() {
   initApplicationMenu();
   initPager();
@@ -662,7 +807,8 @@ void DockPanel::loadAppearanceConfig() {
 void DockPanel::initApplicationMenu() {
   if (showApplicationMenu_) {
     items_.push_back(std::make_unique<ApplicationMenu>(
-        this, model_, orientation_, minSize_, maxSize_));
+        this, model_, parent_->applicationMenuPopup(), orientation_, minSize_,
+        maxSize_));
   }
 }
 
@@ -680,12 +826,41 @@ void DockPanel::initLaunchers() {
 
 void DockPanel::initPager() {
   if (showPager_) {
-    for (int desktop = 1; desktop <= KWindowSystem::numberOfDesktops();
+    desktopCount_ = KWindowSystem::numberOfDesktops();
+    for (int desktop = 1; desktop <= desktopCount_; ++desktop) {
+      items_.push_back(createDesktopSelector(desktop));
+    }
+  }
+}
+
+std::unique_ptr<DockItem> DockPanel::createDesktopSelector(int desktop) {
+  return std::make_unique<DesktopSelector>(
+      this, model_, parent_->wallpaperThumbnailCache(),
+      parent_->windowLayoutTracker(), orientation_, minSize_, maxSize_,
+      desktop, screen_);
+}
+
+void DockPanel::updatePager(int desktopCount) {
+  if (!showPager_ || desktopCount == desktopCount_) {
+    return;
+  }
+
+  // Only the pager items change. The rest of the dock is left untouched.
+  const int firstPagerItem = applicationMenuItemCount();
+  const int itemsToKeep = firstPagerItem + std::min(desktopCount,
+                                                    desktopCount_);
+  if (desktopCount < desktopCount_) {
+    items_.erase(items_.begin() + itemsToKeep,
+                 items_.begin() + firstPagerItem + desktopCount_);
+  } else {
+    for (int desktop = desktopCount_ + 1; desktop <= desktopCount;
          ++desktop) {
-      items_.push_back(std::make_unique<DesktopSelector>(
-          this, model_, orientation_, minSize_, maxSize_, desktop, screen_));
+      items_.insert(items_.begin() + firstPagerItem + desktop - 1,
+                    createDesktopSelector(desktop));
     }
   }
+  desktopCount_ = desktopCount;
+  resizeTaskManager(itemsToKeep);
 }
 
 void DockPanel::initTasks() {
@@ -727,23 +902,77 @@ void DockPanel::addTask(const TaskInfo& task) {
     }
   }
 
+  // The application might be found by a key other than its task command e.g.
+  // its Flatpak ID or WM class, so tries its pinned launcher too.
+  if (auto app = model_->findApplication(task.command)) {
+    for (auto& item : items_) {
+      auto* program = dynamic_cast<Program*>(item.get());
+      if (program != nullptr && program->matchesApplication(*app)) {
+        program->appendTask(task);
+        return;
+      }
+    }
+  }
+
   // Adds a new program.
-  auto app = model_->findApplication(task.command);
-  const QString& command = app ? app->taskCommand : task.command;
   int i = 0;
-  for (; i < itemCount() && items_[i]->beforeTask(command); ++i);
-  if (app) {
-    items_.insert(items_.begin() + i, std::make_unique<Program>(
-        this, model_, app->name, orientation_, app->icon, minSize_,
-        maxSize_, app->command, app->taskCommand, /*pinned=*/false));
-  } else {
-    items_.insert(items_.begin() + i, std::make_unique<Program>(
-        this, model_, task.program, orientation_, "xapp", minSize_,
-        maxSize_, task.command, task.command, /*pinned=*/false));
-  }
+  for (; i < itemCount() && items_[i]->beforeTask(task.command); ++i);
+  items_.insert(items_.begin() + i, createTaskProgram(task));
   items_[i]->addTask(task);
 }
 
+std::unique_ptr<DockItem> DockPanel::createTaskProgram(const TaskInfo& task) {
+  // The application might be found by a key other than its task command, so
+  // the program matches the task's command instead.
+  if (auto app = model_->findApplication(task.command)) {
+    return std::make_unique<Program>(
+        this, model_, app->name, orientation_, app->icon, minSize_, maxSize_,
+        app->command, task.command, /*pinned=*/false);
+  }
+  if (auto rule = model_->findIconOverrideRule(
+      task.program, task.name, task.command)) {
+    return std::make_unique<Program>(
+        this, model_, rule->name.isEmpty() ? task.program : rule->name,
+        orientation_, rule->icon, minSize_, maxSize_,
+        rule->command.isEmpty() ? task.command : rule->command, task.command,
+        /*pinned=*/false);
+  }
+  return std::make_unique<Program>(
+      this, model_, task.program, orientation_, "xapp", minSize_, maxSize_,
+      task.command, task.command, /*pinned=*/false);
+}
+
+void DockPanel::updateTaskIconOverride(WId wId) {
+  for (int i = 0; i < itemCount(); ++i) {
+    auto* program = dynamic_cast<Program*>(items_[i].get());
+    if (program == nullptr || !program->hasTask(wId)) {
+      continue;
+    }
+
+    // Only an unpinned program created for this task alone follows its name.
+    // An application's program doesn't, as applications take precedence over
+    // the rules.
+    if (program->pinned() || program->taskCount() > 1 ||
+        model_->findApplication(program->taskCommand_)) {
+      return;
+    }
+
+    const TaskInfo task = taskHelper_.getTaskInfo(wId);
+    auto replacement = createTaskProgram(task);
+    const auto* newProgram = static_cast<const Program*>(replacement.get());
+    if (newProgram->label_ == program->label_ &&
+        newProgram->getIconName() == program->getIconName() &&
+        newProgram->command_ == program->command_) {
+      return;
+    }
+
+    replacement->addTask(task);
+    items_[i] = std::move(replacement);
+    resizeTaskManager(i);
+    return;
+  }
+}
+
 void DockPanel::removeTask(WId wId) {
   for (int i = 0; i < itemCount(); ++i) {
     if (items_[i]->removeTask(wId)) {
@@ -896,6 +1125,7 @@ void DockPanel::updateLayout() {
     animationTimer_->start(32 - animationSpeed_);
   } else {
     isMinimized_ = true;
+    updateSuspended();
     resize(minWidth_, minHeight_);
     update();
   }
@@ -1024,13 +1254,30 @@ void DockPanel::updateLayout(int x, int y) {
 
   resize(maxWidth_, maxHeight_);
   isMinimized_ = false;
+  updateSuspended();
   update();
 }
 
-void DockPanel::resizeTaskManager() {
+void DockPanel::resizeTaskManager(int itemsToKeep) {
   // Re-calculate panel's size.
   initLayoutVars();
 
+  if (isSuspended_) {
+    // The minimized dock, e.g. the auto-hide strip, still needs to follow the
+    // number of items, but the items are only laid out when they can be seen
+    // again.
+    if (isMinimized_) {
+      if (isHorizontal()) {
+        backgroundWidth_ = minWidth_;
+      } else {
+        backgroundHeight_ = minHeight_;
+      }
+      resize(minWidth_, minHeight_);
+    }
+    layoutPending_ = true;
+    return;
+  }
+
   if (isMinimized_) {
     updateLayout();
     return;
@@ -1045,8 +1292,6 @@ void DockPanel::resizeTaskManager() {
     }
   }
 
-  const int itemsToKeep = (showApplicationMenu_ ? 1 : 0) +
-      (showPager_ ? KWindowSystem::numberOfDesktops() : 0);
   int left = 0;
   int top = 0;
   for (int i = 0; i < itemCount(); ++i) {
@@ -1182,7 +1427,10 @@ int DockPanel::findActiveItem(int x, int y) {
 }
 
 void DockPanel::showTooltip(int x, int y) {
-  int i = findActiveItem(x, y);
+  showOrHideTooltip(findActiveItem(x, y));
+}
+
+void DockPanel::showOrHideTooltip(int i) {
   if (i < 0 || i >= itemCount()) {
     tooltip_.hide();
   } else {
@@ -25,9 +25,11 @@
 #include <QAction>
 #include <QMenu>
 #include <QMouseEvent>
+#include <QHideEvent>
 #include <QPaintEvent>
 #include <QPoint>
 #include <QRect>
+#include <QShowEvent>
 #include <QSize>
 #include <QString>
 #include <QTimer>
@@ -46,6 +48,7 @@
 #include "tooltip.h"
 #include "wallpaper_settings_dialog.h"
 #include "utils/task_helper.h"
+#include "utils/tick_scheduler.h"
 
 namespace ksmoothdock {
 
@@ -74,6 +77,11 @@ class DockPanel : public QWidget {
                                        const QRect& subMenuGeometry);
   void addPanelSettings(QMenu* menu);
 
+  // The scheduler for the items' periodic work, shared by all docks. The
+  // items subscribe with the dock as the owner, so that their work is paused
+  // while the dock is suspended.
+  TickScheduler* tickScheduler();
+
  public slots:
   // Reloads the items and updates the dock.
   void reload();
@@ -86,6 +94,7 @@ class DockPanel : public QWidget {
 
   void onCurrentDesktopChanged();
   void onCurrentActivityChanged();
+  void onIconOverrideRulesChanged();
 
   void onDockLaunchersChanged(int dockId) {
     if (dockId_ == dockId) {
@@ -116,11 +125,8 @@ class DockPanel : public QWidget {
 
   void togglePager();
 
-  void updatePager() {
-    if (showPager_) {
-      reload();
-    }
-  }
+  // Adds or removes pager items when the number of desktops has changed.
+  void updatePager(int desktopCount);
 
   void toggleTaskManager() {
     model_->setShowTaskManager(dockId_, taskManagerAction_->isChecked());
@@ -166,6 +172,7 @@ class DockPanel : public QWidget {
   void onWindowRemoved(WId wId);
   void onWindowChanged(WId wId, NET::Properties properties,
                        NET::Properties2 properties2);
+  void onActiveWindowChanged();
 
  protected:
   virtual void paintEvent(QPaintEvent* e) override;
@@ -173,6 +180,9 @@ class DockPanel : public QWidget {
   virtual void mousePressEvent(QMouseEvent* e) override;
   virtual void enterEvent(QEvent* e) override;
   virtual void leaveEvent(QEvent* e) override;
+  virtual void showEvent(QShowEvent* e) override;
+  virtual void hideEvent(QHideEvent* e) override;
+  virtual void changeEvent(QEvent* e) override;
 
  private:
   // The space between the tooltip and the dock.
@@ -201,7 +211,7 @@ class DockPanel : public QWidget {
   }
 
   int pagerItemCount() const {
-    return showPager_ ? KWindowSystem::numberOfDesktops() : 0;
+    return showPager_ ? desktopCount_ : 0;
   }
 
   int clockItemCount() const {
@@ -220,13 +230,42 @@ class DockPanel : public QWidget {
 
   void initLaunchers();
   void initApplicationMenu();
+  void showAddPanelDialog(AddPanelDialog::Mode mode);
+
+  // Whether the active window covers the whole dock, either because it is
+  // fullscreen or because the visibility mode lets windows cover the dock.
+  bool isCoveredByActiveWindow();
+
+  // Whether a window covers the whole dock.
+  // Args:
+  //   frameGeometry: the window's geometry, including its frame.
+  //   fullScreen: whether the window is fullscreen.
+  //   aboveDock: whether the window is above the dock in the stacking order.
+  bool isCoveredBy(const QRect& frameGeometry, bool fullScreen,
+                   bool aboveDock) const;
+
+  // Suspends layout, painting and the items' periodic work while the dock
+  // is hidden or covered, and resumes them when it can be seen again.
+  void updateSuspended();
+
+  // Runs the layout that was deferred while the dock was suspended.
+  void catchUpLayout();
+
   void initPager();
+  std::unique_ptr<DockItem> createDesktopSelector(int desktop);
   void initTasks();
   void reloadTasks();
   void addTask(const TaskInfo& task);
   void addTask(WId wId) { addTask(taskHelper_.getTaskInfo(wId)); }
   void removeTask(WId wId);
   void updateTask(WId wId);
+  // Re-evaluates the icon override rules for the task after its name has
+  // changed, as many applications only set their final title after mapping
+  // their windows.
+  void updateTaskIconOverride(WId wId);
+  // Creates the unpinned program of a new task, for its application if any,
+  // otherwise from the matching icon override rule.
+  std::unique_ptr<DockItem> createTaskProgram(const TaskInfo& task);
   void initClock();
 
   void initLayoutVars();
@@ -240,7 +279,13 @@ class DockPanel : public QWidget {
 
   // Resizes the task manager part of the panel. This needs to not interfere
   // with the zooming.
-  void resizeTaskManager();
+  void resizeTaskManager() {
+    resizeTaskManager(applicationMenuItemCount() + pagerItemCount());
+  }
+
+  // Resizes the panel after the items from index itemsToKeep on have been
+  // added or removed. The items before it keep their sizes and positions.
+  void resizeTaskManager(int itemsToKeep);
 
   void setStrut(int width);
 
@@ -249,6 +294,9 @@ class DockPanel : public QWidget {
 
   // Shows the appropriate tooltip given the mouse position.
   void showTooltip(int x, int y);
+  // Shows the tooltip for the active item at the specified index, or hides
+  // the tooltip if there is no active item.
+  void showOrHideTooltip(int i);
   // Shows tool tip for the item at the specified index.
   void showTooltip(int i);
 
@@ -268,6 +316,8 @@ class DockPanel : public QWidget {
   PanelVisibility visibility_;
   bool showApplicationMenu_;
   bool showPager_;
+  // The number of desktops that the pager has items for.
+  int desktopCount_;
   bool showClock_;
   int minSize_;
   int maxSize_;
@@ -317,13 +367,15 @@ class DockPanel : public QWidget {
   // Actions to set the dock on a specific screen.
   std::vector<QAction*> screenActions_;
 
-  KAboutApplicationDialog aboutDialog_;
-  AddPanelDialog addPanelDialog_;
-  AppearanceSettingsDialog appearanceSettingsDialog_;
-  EditLaunchersDialog editLaunchersDialog_;
-  ApplicationMenuSettingsDialog applicationMenuSettingsDialog_;
-  WallpaperSettingsDialog wallpaperSettingsDialog_;
-  TaskManagerSettingsDialog taskManagerSettingsDialog_;
+  // Dialogs, created on first use.
+  std::unique_ptr<KAboutApplicationDialog> aboutDialog_;
+  std::unique_ptr<AddPanelDialog> addPanelDialog_;
+  std::unique_ptr<AppearanceSettingsDialog> appearanceSettingsDialog_;
+  std::unique_ptr<EditLaunchersDialog> editLaunchersDialog_;
+  std::unique_ptr<ApplicationMenuSettingsDialog>
+      applicationMenuSettingsDialog_;
+  std::unique_ptr<WallpaperSettingsDialog> wallpaperSettingsDialog_;
+  std::unique_ptr<TaskManagerSettingsDialog> taskManagerSettingsDialog_;
 
   TaskHelper taskHelper_;
   KActivities::Consumer activityManager_;
@@ -332,6 +384,11 @@ class DockPanel : public QWidget {
   Tooltip tooltip_;
 
   bool isMinimized_;
+  // While suspended, window events only update the items and the minimized
+  // dock's size. The items' layout is deferred until the dock can be seen
+  // again.
+  bool isSuspended_;
+  bool layoutPending_;
   bool isResizing_;
   bool isEntering_;
   bool isLeaving_;
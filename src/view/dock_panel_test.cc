@@ -18,6 +18,7 @@
 
 #include "dock_panel.h"
 
+#include <algorithm>
 #include <memory>
 
 #include <QTemporaryDir>
@@ -26,6 +27,7 @@
 #include <KWindowSystem>
 
 #include "multi_dock_view.h"
+#include "program.h"
 
 namespace ksmoothdock {
 
@@ -37,7 +39,8 @@ class DockPanelTest: public QObject {
  private slots:
   void init() {
     QTemporaryDir configDir;
-    model_ = std::make_unique<MultiDockModel>(configDir.path());
+    model_ = std::make_unique<MultiDockModel>(configDir.path(),
+                                              cacheDir_.path());
     model_->addDock();
     view_ = std::make_unique<MultiDockView>(model_.get());
     dock_ = std::make_unique<DockPanel>(view_.get(), model_.get(), kDockId);
@@ -55,9 +58,23 @@ class DockPanelTest: public QObject {
   // Tests toggling the pager.
   void togglePager();
 
+  // Tests adding and removing pager items when the number of desktops has
+  // changed.
+  void updatePager();
+
+  // Tests that the items' layout is deferred while the dock is suspended,
+  // and caught up with when the dock can be seen again.
+  void suspendLayout();
+
+  // Tests finding out if a window covers the dock.
+  void isCoveredBy();
+
   // Tests toggling the clock.
   void toggleClock();
 
+  // Tests matching a launcher to an application found by another key.
+  void programMatchesApplication();
+
  private:
   void verifyPosition(PanelPosition position) {
     QCOMPARE(dock_->position_, position);
@@ -99,12 +116,30 @@ class DockPanelTest: public QObject {
     QCOMPARE(dock_->itemCount(), itemCount);
   }
 
+  // Verifies that the items from index firstItem on are laid out next to
+  // each other in the minimized dock.
+  void verifyMinimizedLayout(int firstItem) {
+    QVERIFY(dock_->isMinimized_);
+    for (int i = std::max(firstItem, 1); i < dock_->itemCount(); ++i) {
+      const auto& previous = dock_->items_[i - 1];
+      const auto& item = dock_->items_[i];
+      if (dock_->isHorizontal()) {
+        QCOMPARE(item->left_, previous->left_ + previous->getMinWidth() +
+                 dock_->itemSpacing_);
+      } else {
+        QCOMPARE(item->top_, previous->top_ + previous->getMinHeight() +
+                 dock_->itemSpacing_);
+      }
+    }
+  }
+
   void verifyClock(bool enabled, int itemCount) {
     QCOMPARE(dock_->showClock_, enabled);
     QCOMPARE(dock_->clockAction_->isChecked(), enabled);
     QCOMPARE(dock_->itemCount(), itemCount);
   }
 
+  QTemporaryDir cacheDir_;
   std::unique_ptr<MultiDockModel> model_;
   std::unique_ptr<MultiDockView> view_;
   std::unique_ptr<DockPanel> dock_;
@@ -139,7 +174,34 @@ void DockPanelTest::toggleApplicationMenu() {
 }
 
 void DockPanelTest::togglePager() {
-  // TODO(dangvd)
+  const int itemCount = dock_->itemCount();
+  dock_->pagerAction_->trigger();
+  verifyPager(true, itemCount + KWindowSystem::numberOfDesktops());
+  dock_->pagerAction_->trigger();
+  verifyPager(false, itemCount);
+}
+
+void DockPanelTest::updatePager() {
+  // A hidden dock defers laying out its items.
+  dock_->show();
+  QVERIFY(!dock_->isSuspended_);
+  dock_->pagerAction_->trigger();
+  const int itemCount = dock_->itemCount();
+  const int desktopCount = KWindowSystem::numberOfDesktops();
+  const int firstPagerItem = dock_->applicationMenuItemCount();
+  const int afterPager = firstPagerItem + desktopCount;
+  QVERIFY(afterPager < itemCount);  // e.g. the clock.
+  const DockItem* firstItemAfterPager = dock_->items_[afterPager].get();
+
+  dock_->updatePager(desktopCount + 2);
+  QCOMPARE(dock_->itemCount(), itemCount + 2);
+  QCOMPARE(dock_->items_[afterPager + 2].get(), firstItemAfterPager);
+  verifyMinimizedLayout(afterPager);
+
+  dock_->updatePager(desktopCount);
+  QCOMPARE(dock_->itemCount(), itemCount);
+  QCOMPARE(dock_->items_[afterPager].get(), firstItemAfterPager);
+  verifyMinimizedLayout(afterPager);
 }
 
 void DockPanelTest::toggleClock() {
@@ -150,6 +212,72 @@ void DockPanelTest::toggleClock() {
   verifyClock(true, itemCount);
 }
 
+void DockPanelTest::programMatchesApplication() {
+  const QString command =
+      "/usr/bin/flatpak run --branch=stable org.telegram.desktop";
+  Program launcher(dock_.get(), model_.get(), "Telegram", Qt::Horizontal,
+                   "telegram", 48, 128, command, getTaskCommand(command),
+                   /*pinned=*/true);
+
+  // The Telegram window's class is its Flatpak ID, not 'flatpak'.
+  ApplicationEntry telegram("Telegram", "Messenger", "telegram", command, "");
+  telegram.flatpakAppId = "org.telegram.desktop";
+  QVERIFY(launcher.matchesApplication(telegram));
+
+  ApplicationEntry discord(
+      "Discord", "Messenger", "discord",
+      "/usr/bin/flatpak run --branch=stable com.discordapp.Discord", "");
+  discord.flatpakAppId = "com.discordapp.Discord";
+  QVERIFY(!launcher.matchesApplication(discord));
+}
+
+void DockPanelTest::suspendLayout() {
+  dock_->show();
+  dock_->pagerAction_->trigger();
+  dock_->visibilityAutoHideAction_->trigger();
+  QVERIFY(dock_->isSuspended_);
+  const int width = dock_->width();
+  const int desktopCount = KWindowSystem::numberOfDesktops();
+  const int afterPager = dock_->applicationMenuItemCount() + desktopCount;
+  const int left = dock_->items_[afterPager]->left_;
+
+  // The auto-hide strip follows the number of items, but the items are not
+  // laid out.
+  dock_->updatePager(desktopCount + 2);
+  QVERIFY(dock_->layoutPending_);
+  QCOMPARE(dock_->width(), dock_->minWidth_);
+  QVERIFY(dock_->width() > width);
+  QCOMPARE(dock_->items_[afterPager + 2]->left_, left);
+
+  dock_->enterEvent(nullptr);
+  QVERIFY(!dock_->isSuspended_);
+  QVERIFY(!dock_->layoutPending_);
+  verifyMinimizedLayout(afterPager);
+}
+
+void DockPanelTest::isCoveredBy() {
+  dock_->show();
+  const QRect dockGeometry = dock_->geometry();
+  const QRect covering = dockGeometry.adjusted(-10, -10, 10, 10);
+  const QRect partlyCovering = dockGeometry.adjusted(10, 0, 0, 0);
+
+  // A fullscreen window covers the dock whatever its visibility mode.
+  QVERIFY(dock_->isCoveredBy(covering, /*fullScreen=*/true,
+                             /*aboveDock=*/true));
+  QVERIFY(!dock_->isCoveredBy(covering, /*fullScreen=*/false,
+                              /*aboveDock=*/true));
+  QVERIFY(!dock_->isCoveredBy(partlyCovering, /*fullScreen=*/true,
+                              /*aboveDock=*/true));
+  QVERIFY(!dock_->isCoveredBy(covering, /*fullScreen=*/true,
+                              /*aboveDock=*/false));
+
+  dock_->visibilityWindowsCanCoverAction_->trigger();
+  QVERIFY(dock_->isCoveredBy(covering, /*fullScreen=*/false,
+                             /*aboveDock=*/true));
+  QVERIFY(!dock_->isCoveredBy(covering, /*fullScreen=*/false,
+                              /*aboveDock=*/false));
+}
+
 }  // namespace ksmoothdock
 
 QTEST_MAIN(ksmoothdock::DockPanelTest)
@@ -21,6 +21,7 @@
 
 #include <QDir>
 #include <QFileDialog>
+#include <QHash>
 #include <QMimeData>
 #include <QUrl>
 #include <QVariant>
@@ -28,6 +29,7 @@
 
 #include <KDesktopFile>
 #include <KIconLoader>
+#include <KIconTheme>
 #include <KLocalizedString>
 
 #include "program.h"
@@ -322,10 +324,28 @@ void EditLaunchersDialog::saveData() {
   model_->saveDockLauncherConfigs(dockId_);
 }
 
+QIcon EditLaunchersDialog::getCommandIcon(const QString& iconName) {
+  static QString iconTheme;
+  static QHash<QString, QIcon> icons;
+  const QString currentIconTheme = KIconLoader::global()->theme()
+      ? KIconLoader::global()->theme()->internalName() : QString();
+  if (currentIconTheme != iconTheme) {
+    icons.clear();
+    iconTheme = currentIconTheme;
+  }
+
+  auto it = icons.constFind(iconName);
+  if (it == icons.constEnd()) {
+    it = icons.insert(iconName, QIcon(KIconLoader::global()->loadIcon(
+        iconName, KIconLoader::NoGroup, kListIconSize)));
+  }
+  return it.value();
+}
+
 void EditLaunchersDialog::populateInternalCommands() {
   ui->internalCommands->addItem(i18n("Use an internal command"));  // header
   ui->internalCommands->addItem(
-      getListItemIcon("user-desktop"),
+      getCommandIcon("user-desktop"),
       i18n("Show Desktop"),
       QVariant::fromValue(LauncherInfo("user-desktop", kShowDesktopCommand)));
 }
@@ -361,7 +381,7 @@ void EditLaunchersDialog::populateDBusCommands() {
   ui->dbusCommands->addItem(i18n("Use a D-Bus command"));  // header
   for (int i = 0; i < kNumItems; ++i) {
     ui->dbusCommands->addItem(
-        getListItemIcon(kItems[i][1]),
+        getCommandIcon(kItems[i][1]),
         i18n(kItems[i][0]),
         QVariant::fromValue(LauncherInfo(kItems[i][1], kItems[i][2])));
   }
@@ -450,7 +470,7 @@ void EditLaunchersDialog::populateWebCommands() {
   ui->webCommands->addItem(i18n("Launch a Website"));  // header
   for (int i = 0; i < kNumItems; ++i) {
     ui->webCommands->addItem(
-        getListItemIcon(kItems[i][1]),
+        getCommandIcon(kItems[i][1]),
         i18n(kItems[i][0]),
         QVariant::fromValue(LauncherInfo(kItems[i][1], kItems[i][2])));
   }
@@ -476,7 +496,7 @@ void EditLaunchersDialog::populateDirCommands() {
   ui->dirCommands->addItem(i18n("Create a shortcut to a directory"));  // header
   for (int i = 0; i < kNumItems; ++i) {
     ui->dirCommands->addItem(
-        getListItemIcon(kItems[i][1]),
+        getCommandIcon(kItems[i][1]),
         i18n(kItems[i][0].toStdString().c_str()),
         QVariant::fromValue(LauncherInfo(kItems[i][1], kItems[i][2])));
   }
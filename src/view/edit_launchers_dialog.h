@@ -114,6 +114,10 @@ class EditLaunchersDialog : public QDialog {
         KIconLoader::NoGroup, kListIconSize));
   }
 
+  // Gets the icon of a built-in command. These icons are shared by the
+  // dialogs of all docks, until the icon theme changes.
+  static QIcon getCommandIcon(const QString& iconName);
+
   void populateInternalCommands();
   void populateDBusCommands();
   void populateWebCommands();
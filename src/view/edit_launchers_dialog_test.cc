@@ -39,7 +39,8 @@ class EditLaunchersDialogTest: public QObject {
  private slots:
   void init() {
     QTemporaryDir configDir;
-    model_ = std::make_unique<MultiDockModel>(configDir.path());
+    model_ = std::make_unique<MultiDockModel>(configDir.path(),
+                                              cacheDir_.path());
     model_->addDock();
     dialog_ = std::make_unique<EditLaunchersDialog>(nullptr, model_.get(),
                                                     kDockId);
@@ -59,6 +60,7 @@ class EditLaunchersDialogTest: public QObject {
     return static_cast<int>(model_->dockLauncherConfigs(kDockId).size());
   }
 
+  QTemporaryDir cacheDir_;
   std::unique_ptr<MultiDockModel> model_;
   std::unique_ptr<EditLaunchersDialog> dialog_;
 };
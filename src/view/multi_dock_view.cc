@@ -26,6 +26,8 @@ namespace ksmoothdock {
 
 MultiDockView::MultiDockView(MultiDockModel* model)
     : model_(model),
+      applicationMenuPopup_(model),
+      wallpaperThumbnailCache_(model->wallpaperThumbnailsPath()),
       wallpaperHelper_(model) {
   connect(model_, SIGNAL(dockAdded(int)), this, SLOT(onDockAdded(int)));
   connect(model_, SIGNAL(wallpaperChanged(int)), &wallpaperHelper_,
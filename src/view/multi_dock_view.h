@@ -24,9 +24,13 @@
 
 #include <QObject>
 
+#include "application_menu.h"
 #include "dock_panel.h"
 #include <model/multi_dock_model.h>
+#include <utils/tick_scheduler.h>
 #include <utils/wallpaper_helper.h>
+#include <utils/wallpaper_thumbnail_cache.h>
+#include <utils/window_layout_tracker.h>
 
 namespace ksmoothdock {
 
@@ -41,6 +45,24 @@ class MultiDockView : public QObject {
 
   void show();
 
+  // The application menu popup shared by all docks.
+  ApplicationMenuPopup* applicationMenuPopup() {
+    return &applicationMenuPopup_;
+  }
+
+  // The wallpaper thumbnails shared by all docks.
+  WallpaperThumbnailCache* wallpaperThumbnailCache() {
+    return &wallpaperThumbnailCache_;
+  }
+
+  // The scheduler for the periodic work of all docks' items.
+  TickScheduler* tickScheduler() { return &tickScheduler_; }
+
+  // The pager's window layouts shared by all docks.
+  WindowLayoutTracker* windowLayoutTracker() {
+    return &windowLayoutTracker_;
+  }
+
  public slots:
   void exit();
 
@@ -53,6 +75,11 @@ class MultiDockView : public QObject {
   void createDefaultDock();
 
   MultiDockModel* model_;  // No ownership.
+  // Must outlive the docks.
+  ApplicationMenuPopup applicationMenuPopup_;
+  WallpaperThumbnailCache wallpaperThumbnailCache_;
+  WindowLayoutTracker windowLayoutTracker_;
+  TickScheduler tickScheduler_;
   std::unordered_map<int, std::unique_ptr<DockPanel>> docks_;
   WallpaperHelper wallpaperHelper_;
 };
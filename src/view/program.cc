@@ -22,6 +22,7 @@
 
 #include <QGuiApplication>
 #include <QProcess>
+#include <QRect>
 #include <QTimer>
 
 #include <KDesktopFile>
@@ -35,6 +36,9 @@
 
 namespace ksmoothdock {
 
+constexpr int Program::kAttentionIntervalMs;
+constexpr int Program::kHighlightPadding;
+
 Program::Program(DockPanel* parent, MultiDockModel* model, const QString& label,
     Qt::Orientation orientation, const QString& iconName, int minSize,
     int maxSize, const QString& command, const QString& taskCommand, bool pinned)
@@ -43,24 +47,24 @@ Program::Program(DockPanel* parent, MultiDockModel* model, const QString& label,
       command_(command),
       taskCommand_(taskCommand),
       pinned_(pinned),
+      pinAction_(nullptr),
       demandsAttention_(false),
-      attentionStrong_(false) {
-  createMenu();
+      attentionTickId_(0),
+      attentionStrong_(false) {}
 
-  animationTimer_.setInterval(500);
-  connect(&animationTimer_, &QTimer::timeout, this, [this]() {
-    attentionStrong_ = !attentionStrong_;
-    parent_->update();
-  });
+Program::~Program() {
+  if (attentionTickId_ != 0) {
+    parent_->tickScheduler()->unsubscribe(attentionTickId_);
+  }
 }
 
 void Program::draw(QPainter *painter) const {
   if ((!tasks_.empty() && active()) || attentionStrong_) {
     drawHighlightedIcon(model_->backgroundColor(), left_, top_, getWidth(), getHeight(),
-                        5, size_ / 8, painter);
+                        kHighlightPadding, size_ / 8, painter);
   } else if (!tasks_.empty()) {
     drawHighlightedIcon(model_->backgroundColor(), left_, top_, getWidth(), getHeight(),
-                        5, size_ / 8, painter, 0.25);
+                        kHighlightPadding, size_ / 8, painter, 0.25);
   }
   IconBasedDockItem::draw(painter);
 }
@@ -101,7 +105,10 @@ void Program::mousePressEvent(QMouseEvent* e) {
       }
     }
   } else if (e->button() == Qt::RightButton) {
-    menu_.popup(e->globalPos());
+    if (!menu_) {
+      createMenu();
+    }
+    menu_->popup(e->globalPos());
   }
 }
 
@@ -114,20 +121,22 @@ QString Program::getLabel() const {
 
 bool Program::addTask(const TaskInfo& task) {
   if (areTheSameCommand(taskCommand_, task.command)) {
-    tasks_.push_back(ProgramTask(task.wId, task.name, task.demandsAttention));
-    if (task.demandsAttention) {
-      setDemandsAttention(true);
-    }
+    appendTask(task);
     return true;
   }
   return false;
 }
 
-bool Program::updateTask(const TaskInfo& task) {
-  if (!areTheSameCommand(taskCommand_, task.command)) {
-    return false;
+void Program::appendTask(const TaskInfo& task) {
+  tasks_.push_back(ProgramTask(task.wId, task.name, task.demandsAttention));
+  if (task.demandsAttention) {
+    setDemandsAttention(true);
   }
+}
 
+bool Program::updateTask(const TaskInfo& task) {
+  // Matches by window ID only, as the task might have been attached via its
+  // application rather than its command.
   for (auto& existingTask : tasks_) {
     if (existingTask.wId == task.wId) {
       existingTask.demandsAttention = task.demandsAttention;
@@ -139,6 +148,11 @@ bool Program::updateTask(const TaskInfo& task) {
   return false;
 }
 
+bool Program::matchesApplication(const ApplicationEntry& app) const {
+  // Not by task command, as e.g. all Flatpak applications have 'flatpak'.
+  return command_ == app.command;
+}
+
 bool Program::removeTask(WId wId) {
   for (int i = 0; i < static_cast<int>(tasks_.size()); ++i) {
     if (tasks_[i].wId == wId) {
@@ -189,22 +203,23 @@ void Program::launch(const QString& command) {
 }
 
 void Program::createMenu() {
-  menu_.addAction(QIcon::fromTheme("configure"), i18n("Edit &Launchers"), parent_,
+  menu_ = std::make_unique<QMenu>();
+  menu_->addAction(QIcon::fromTheme("configure"), i18n("Edit &Launchers"), parent_,
                   [this] { parent_->showEditLaunchersDialog(); });
 
   if (model_->showTaskManager(parent_->dockId())) {
-    menu_.addAction(QIcon::fromTheme("configure"),
+    menu_->addAction(QIcon::fromTheme("configure"),
                     i18n("Task Manager &Settings"),
                     parent_,
                     [this] { parent_->showTaskManagerSettingsDialog(); });
   }
 
   if (!isCommandInternal(command_) && !isCommandDBus(command_)) {
-    menu_.addAction(QIcon::fromTheme("list-add"), i18n("&New Instance"), this,
+    menu_->addAction(QIcon::fromTheme("list-add"), i18n("&New Instance"), this,
                     [this] { launch(); });
   }
 
-  pinAction_ = menu_.addAction(
+  pinAction_ = menu_->addAction(
       i18n("Pinned"), this,
       [this] {
         pinUnpin();
@@ -212,8 +227,8 @@ void Program::createMenu() {
   pinAction_->setCheckable(true);
   pinAction_->setChecked(pinned_);
 
-  menu_.addSeparator();
-  parent_->addPanelSettings(&menu_);
+  menu_->addSeparator();
+  parent_->addPanelSettings(menu_.get());
 }
 
 void Program::setDemandsAttention(bool value) {
@@ -223,12 +238,26 @@ void Program::setDemandsAttention(bool value) {
 
   demandsAttention_ = value;
   if (demandsAttention_) {
-    animationTimer_.start();
-  } else if (animationTimer_.isActive()) {
-    animationTimer_.stop();
+    attentionTickId_ = parent_->tickScheduler()->subscribe(
+        parent_, kAttentionIntervalMs, [this] {
+          attentionStrong_ = !attentionStrong_;
+          updateHighlight();
+        });
+  } else {
+    parent_->tickScheduler()->unsubscribe(attentionTickId_);
+    attentionTickId_ = 0;
+    attentionStrong_ = false;
+    updateHighlight();
   }
 }
 
+void Program::updateHighlight() {
+  // Only repaints the item and its highlight's padding.
+  parent_->update(QRect(left_, top_, getWidth(), getHeight())
+      .adjusted(-kHighlightPadding, -kHighlightPadding, kHighlightPadding,
+                kHighlightPadding));
+}
+
 void Program::updateDemandsAttention() {
   for (const auto& task : tasks_) {
     if (task.demandsAttention) {
@@ -19,12 +19,12 @@
 #ifndef KSMOOTHDOCK_PROGRAM_H_
 #define KSMOOTHDOCK_PROGRAM_H_
 
+#include <memory>
 #include <vector>
 
 #include <QAction>
 #include <QMenu>
 #include <QPixmap>
-#include <QTimer>
 
 #include <KWindowSystem>
 
@@ -52,7 +52,7 @@ class Program : public QObject, public IconBasedDockItem {
       Qt::Orientation orientation, const QString& iconName, int minSize,
       int maxSize, const QString& command, const QString& taskCommand, bool pinned);
 
-  ~Program() override = default;
+  ~Program() override;
 
   void draw(QPainter* painter) const override;
 
@@ -70,6 +70,11 @@ class Program : public QObject, public IconBasedDockItem {
 
   bool beforeTask(const QString& command) override;
 
+  // Whether this program launches the given application. A task whose window
+  // class differs from this program's task command can still belong to it if
+  // the application was found by another key e.g. its Flatpak ID.
+  bool matchesApplication(const ApplicationEntry& app) const;
+
   bool shouldBeRemoved() override { return taskCount() == 0 && !pinned_; }
 
   int taskCount() const { return static_cast<int>(tasks_.size()); }
@@ -93,11 +98,21 @@ class Program : public QObject, public IconBasedDockItem {
   static void lockScreen() { launch(kLockScreenCommand); }
 
  private:
+  static constexpr int kAttentionIntervalMs = 500;
+  static constexpr int kHighlightPadding = 5;
+
+  // Creates the context menu. This is done on first use.
   void createMenu();
 
+  // Adds the task without checking its command.
+  void appendTask(const TaskInfo& task);
+
   void setDemandsAttention(bool value);
   void updateDemandsAttention();
 
+  // Repaints the highlight for demanding attention.
+  void updateHighlight();
+
   MultiDockModel* model_;
   QString name_;
   QString command_;
@@ -105,13 +120,14 @@ class Program : public QObject, public IconBasedDockItem {
   bool pinned_;
   std::vector<ProgramTask> tasks_;
 
-  // Context (right-click) menu.
-  QMenu menu_;
+  // Context (right-click) menu, created on first use.
+  std::unique_ptr<QMenu> menu_;
   QAction* pinAction_;
 
   // Demands attention logic.
   bool demandsAttention_;
-  QTimer animationTimer_;
+  // The subscription to the dock's tick scheduler, or 0 if none.
+  int attentionTickId_;
   bool attentionStrong_;
 
   friend class DockPanel;